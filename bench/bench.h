@@ -0,0 +1,32 @@
+/* ------------------------------------------------------------------------
+   bench.h
+
+   Shared reporting for the scheduler micro-benchmarks.  Each benchmark
+   is a start1() that times a loop with sys_clock() and prints one line
+
+      BENCH <name> ops=<n> ns_per_op=<ns> ops_per_sec=<rate>
+
+   so runs of different kernel builds can be compared with grep/awk.
+   Every benchmark but fork_join takes its ROUNDS from BENCHFLAGS, and
+   those sized by the process table (zap_fan_in, dispatch_ring and
+   zap_chain) their N as well, to go with a larger PROC_LIMIT, e.g.
+
+      make PROC_LIMIT=4096 BENCHFLAGS='-DN=3000 -DROUNDS=2' bench
+
+   ------------------------------------------------------------------------ */
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdio.h>
+
+static void bench_report(char *name, int ops, int start_us)
+{
+   int elapsed = sys_clock() - start_us;
+
+   if (elapsed <= 0)
+      elapsed = 1;
+   printf("BENCH %s ops=%d ns_per_op=%.1f ops_per_sec=%.0f\n", name, ops,
+          elapsed * 1000.0 / ops, ops * 1000000.0 / elapsed);
+} /* bench_report */
+
+#endif /* _BENCH_H */
@@ -0,0 +1,42 @@
+/*
+  Fork/join churn with a full process table.
+
+  Each round start1 forks lower priority children until fork1() reports
+  the table full, then joins them all.  One op is one child's fork1,
+  run, quit and join.
+*/
+
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+#ifndef ROUNDS
+#define ROUNDS 1000
+#endif
+
+int Child(char *);
+
+int start1(char *arg)
+{
+   int round, kids, ops, status, start;
+
+   ops = 0;
+   start = sys_clock();
+   for (round = 0; round < ROUNDS; round++) {
+      for (kids = 0; fork1("Child", Child, NULL, USLOSS_MIN_STACK, 2) >= 0;
+           kids++)
+         ;
+      ops += kids;
+      while (kids-- > 0)
+         join(&status);
+   }
+   bench_report("table_churn", ops, start);
+   quit(0);
+   return 0;
+} /* start1 */
+
+int Child(char *arg)
+{
+   quit(0);
+   return 0;
+} /* Child */
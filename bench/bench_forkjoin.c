@@ -0,0 +1,38 @@
+/*
+  fork1 + join round trip.
+
+  start1 forks a lower priority child and joins it; the child runs only
+  once start1 blocks in join and quits at once.  One op is one fork1,
+  one dispatch to the child, its quit and the join that reaps it.
+*/
+
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+#define OPS 20000
+
+int Child(char *);
+
+int start1(char *arg)
+{
+   int i, status, start;
+
+   start = sys_clock();
+   for (i = 0; i < OPS; i++) {
+      if (fork1("Child", Child, NULL, USLOSS_MIN_STACK, 2) < 0 ||
+          join(&status) < 0) {
+         printf("bench_forkjoin: fork1 or join failed\n");
+         quit(1);
+      }
+   }
+   bench_report("fork_join", OPS, start);
+   quit(0);
+   return 0;
+} /* start1 */
+
+int Child(char *arg)
+{
+   quit(0);
+   return 0;
+} /* Child */
@@ -0,0 +1,73 @@
+/*
+  Worker pool launch with fork_many and join_all.
+
+  Each round start1 creates a pool of POOL children at its own priority
+  in one fork_many() call, then reaps them with join_all(); the children
+  all run and quit before start1 is resumed, so one join_all() reaps the
+  whole pool.  One op is one child's creation, run, quit and join.
+  Build with -DLOOP_FORK to create and reap the same pool with a
+  fork1_ptr() and a join() per child, for comparison.
+*/
+
+#include <usloss.h>
+#include <phase1.h>
+#include "phase1ext.h"
+#include "bench.h"
+
+#ifndef ROUNDS
+#define ROUNDS 1000
+#endif
+#define POOL   32
+
+int Child(void *);
+
+int start1(char *arg)
+{
+   fork_spec specs[POOL];
+#ifndef LOOP_FORK
+   int pids[POOL], codes[POOL];
+#endif
+   int round, i, ops, status, start;
+
+   for (i = 0; i < POOL; i++) {
+      specs[i].name = "Child";
+      specs[i].func = Child;
+      specs[i].arg = NULL;
+      specs[i].stacksize = USLOSS_MIN_STACK;
+      specs[i].priority = 1;
+   }
+
+   ops = 0;
+   start = sys_clock();
+   for (round = 0; round < ROUNDS; round++) {
+#ifdef LOOP_FORK
+      for (i = 0; i < POOL; i++)
+         if (fork1_ptr(specs[i].name, specs[i].func, specs[i].arg,
+                       specs[i].stacksize, specs[i].priority) < 0)
+            break;
+#else
+      i = fork_many(specs, POOL, NULL);
+#endif
+      if (i != POOL) {
+         printf("bench_forkmany: created %d of %d\n", i, POOL);
+         quit(1);
+      }
+      ops += POOL;
+#ifdef LOOP_FORK
+      while (i-- > 0)
+         join(&status);
+#else
+      while (i > 0 && (status = join_all(pids, codes, POOL)) > 0)
+         i -= status;
+#endif
+   }
+   bench_report("fork_many", ops, start);
+   quit(0);
+   return 0;
+} /* start1 */
+
+int Child(void *arg)
+{
+   quit(0);
+   return 0;
+} /* Child */
@@ -0,0 +1,56 @@
+/*
+  Dispatch around a full process table.
+
+  N processes at one priority pass a token around a ring: each waits in
+  block_me(), unblocks the next and blocks again, so every dispatch
+  brings in a different process's table entry.  One op is one dispatch.
+*/
+
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+#ifndef ROUNDS
+#define ROUNDS 2000
+#endif
+#ifndef N
+#define N      (MAXPROC - 3)    /* all slots but sentinel, start1, spare */
+#endif
+#define TOKEN_WAIT 11
+
+int Member(char *);
+
+int ring[N];
+
+int start1(char *arg)
+{
+   int i, status, start;
+   char buf[10];
+
+   for (i = 0; i < N; i++) {
+      sprintf(buf, "%d", i);
+      ring[i] = fork1("Member", Member, buf, USLOSS_MIN_STACK, 2);
+   }
+   start = sys_clock();
+   for (i = 0; i < N; i++)
+      join(&status);
+   bench_report("dispatch_ring", N * ROUNDS, start);
+   quit(0);
+   return 0;
+} /* start1 */
+
+int Member(char *arg)
+{
+   int i = atoi(arg), round;
+
+   /* the last member to start sets the token going */
+   if (i == N - 1)
+      unblock_proc(ring[0]);
+   for (round = 0; round < ROUNDS; round++) {
+      block_me(TOKEN_WAIT);
+      unblock_proc(ring[(i + 1) % N]);
+   }
+   quit(0);
+   return 0;
+} /* Member */
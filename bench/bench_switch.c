@@ -0,0 +1,57 @@
+/*
+  Context switch through dispatcher().
+
+  Pinger unblocks the higher priority Ponger, which preempts it at once
+  and goes straight back into block_me(), handing the processor back to
+  Pinger.  Each round trip is two switches; one op is one switch.
+*/
+
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+#ifndef ROUNDS
+#define ROUNDS 50000
+#endif
+#define PONG_BLOCKED 11
+
+int Pinger(char *), Ponger(char *);
+
+int done = 0;
+
+int start1(char *arg)
+{
+   int status;
+
+   fork1("Pinger", Pinger, NULL, USLOSS_MIN_STACK, 3);
+   join(&status);
+   quit(0);
+   return 0;
+} /* start1 */
+
+int Pinger(char *arg)
+{
+   int i, status, ponger, start;
+
+   /* Ponger runs first and blocks */
+   ponger = fork1("Ponger", Ponger, NULL, USLOSS_MIN_STACK, 2);
+
+   start = sys_clock();
+   for (i = 0; i < ROUNDS; i++)
+      unblock_proc(ponger);
+   bench_report("context_switch", 2 * ROUNDS, start);
+
+   done = 1;
+   unblock_proc(ponger);
+   join(&status);
+   quit(0);
+   return 0;
+} /* Pinger */
+
+int Ponger(char *arg)
+{
+   while (!done)
+      block_me(PONG_BLOCKED);
+   quit(0);
+   return 0;
+} /* Ponger */
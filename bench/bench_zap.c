@@ -0,0 +1,54 @@
+/*
+  Zap fan-in, the test18 pattern.
+
+  Each round start1 forks a victim and N zappers, all at lower priority
+  than itself, and joins them.  The zappers run first and all block in
+  zap() on the victim; the victim then quits and wakes every one of
+  them.  One op is one zapper's zap, wake-up and quit, plus its share
+  of the round's forks and joins.
+*/
+
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+#ifndef ROUNDS
+#define ROUNDS 500
+#endif
+#ifndef N
+#define N      (MAXPROC - 3)    /* all slots but sentinel, start1, victim */
+#endif
+
+int Victim(char *), Zapper(char *);
+
+int victim;
+
+int start1(char *arg)
+{
+   int round, i, status, start;
+
+   start = sys_clock();
+   for (round = 0; round < ROUNDS; round++) {
+      victim = fork1("Victim", Victim, NULL, USLOSS_MIN_STACK, 5);
+      for (i = 0; i < N; i++)
+         fork1("Zapper", Zapper, NULL, USLOSS_MIN_STACK, 4);
+      for (i = 0; i < N + 1; i++)
+         join(&status);
+   }
+   bench_report("zap_fan_in", ROUNDS * N, start);
+   quit(0);
+   return 0;
+} /* start1 */
+
+int Zapper(char *arg)
+{
+   zap(victim);
+   quit(0);
+   return 0;
+} /* Zapper */
+
+int Victim(char *arg)
+{
+   quit(0);
+   return 0;
+} /* Victim */
@@ -0,0 +1,56 @@
+/*
+  Wait-for graph walks along a zap chain.
+
+  Each round start1 forks a root and N zappers below itself.  Zapper k
+  zaps zapper k-1 and zapper 1 zaps the root, so each zap() walks the
+  whole chain beneath it before blocking: N(N+1)/2 process visits a
+  round.  The root then quits and the chain unwinds.  One op is one
+  zap, with its share of the round's forks and joins.
+*/
+
+#include <stdlib.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "bench.h"
+
+#ifndef ROUNDS
+#define ROUNDS 500
+#endif
+#ifndef N
+#define N      (MAXPROC - 3)    /* all slots but sentinel, start1, root */
+#endif
+
+int Root(char *), Zapper(char *);
+
+int start1(char *arg)
+{
+   int round, i, status, prev, start;
+   char buf[10];
+
+   start = sys_clock();
+   for (round = 0; round < ROUNDS; round++) {
+      prev = fork1("Root", Root, NULL, USLOSS_MIN_STACK, 5);
+      for (i = 0; i < N; i++) {
+         sprintf(buf, "%d", prev);
+         prev = fork1("Zapper", Zapper, buf, USLOSS_MIN_STACK, 4);
+      }
+      for (i = 0; i < N + 1; i++)
+         join(&status);
+   }
+   bench_report("zap_chain", ROUNDS * N, start);
+   quit(0);
+   return 0;
+} /* start1 */
+
+int Zapper(char *arg)
+{
+   zap(atoi(arg));
+   quit(0);
+   return 0;
+} /* Zapper */
+
+int Root(char *arg)
+{
+   quit(0);
+   return 0;
+} /* Root */
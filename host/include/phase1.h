@@ -0,0 +1,50 @@
+/* ------------------------------------------------------------------------
+   phase1.h
+
+   Definitions for phase 1 of the project (the kernel).
+
+   ------------------------------------------------------------------------ */
+#ifndef _PHASE1_H
+#define _PHASE1_H
+
+#include <usloss.h>
+
+/* maximum number of processes */
+#define MAXPROC      50
+
+/* maximum length of a process name */
+#define MAXNAME      50
+
+/* maximum length of string argument passed to a newly created process */
+#define MAXARG       100
+
+/* maximum number of syscalls */
+#define MAXSYSCALLS  50
+
+#define LOWEST_PRIORITY  6
+#define HIGHEST_PRIORITY 1
+
+/* These functions must be provided by Phase 1. */
+extern int   fork1(char *name, int (*func)(char *), char *arg,
+                   int stacksize, int priority);
+extern int   join(int *status);
+extern void  quit(int status);
+extern int   zap(int pid);
+extern int   is_zapped(void);
+extern int   getpid(void);
+extern void  dump_processes(void);
+extern int   block_me(int block_status);
+extern int   unblock_proc(int pid);
+extern int   read_cur_start_time(void);
+extern void  time_slice(void);
+extern void  dispatcher(void);
+extern int   readtime(void);
+
+extern int   start1(char *);
+
+/* hooks called by the kernel on process lifecycle events (p1.c) */
+extern void  p1_fork(int pid);
+extern void  p1_switch(int old, int new);
+extern void  p1_quit(int pid);
+
+#endif /* _PHASE1_H */
@@ -0,0 +1,54 @@
+/* ------------------------------------------------------------------------
+   usloss.h
+
+   Host-native stand-in for the USLOSS simulator interface.  Contexts are
+   ucontext_t, the clock device is driven by SIGALRM and the console is
+   stdout, so the kernel and the testcases run as ordinary Linux programs.
+
+   ------------------------------------------------------------------------ */
+#ifndef _USLOSS_H
+#define _USLOSS_H
+
+#include <ucontext.h>
+
+/* smallest stack a process may be given */
+#define USLOSS_MIN_STACK (80 * 1024)
+
+/* processor status register bits */
+#define PSR_CURRENT_MODE 0x1
+#define PSR_CURRENT_INT  0x2
+#define PSR_PREV_MODE    0x4
+#define PSR_PREV_INT     0x8
+
+/* interrupt vector */
+#define NUM_INTS   7
+#define CLOCK_INT  0
+#define CLOCK_DEV  0
+#define CLOCK_MS   20   /* clock interrupt period in milliseconds */
+
+#define DEV_OK     0
+
+typedef struct context {
+   ucontext_t     uc;
+   unsigned int   psr;
+} context;
+
+extern void (*int_vec[NUM_INTS])(int dev, void *unit);
+
+extern void         context_init(context *state, unsigned int psr,
+                                 char *stack, int stacksize,
+                                 void (*func)(void));
+extern void         context_switch(context *old, context *new);
+extern unsigned int psr_get(void);
+extern void         psr_set(unsigned int psr);
+extern void         waitint(void);
+extern void         halt(int dumpcore);
+extern void         console(char *fmt, ...);
+extern int          sys_clock(void);
+extern int          device_input(unsigned int dev, int unit, int *status);
+
+/* provided by the kernel */
+extern void startup(void);
+extern void finish(void);
+
+#endif /* _USLOSS_H */
@@ -0,0 +1,220 @@
+/* ------------------------------------------------------------------------
+   usloss.c
+
+   Host-native stand-in for the USLOSS simulator.  Provides main(), the
+   processor status register, context creation and switching on top of
+   ucontext, and a clock device driven by a periodic SIGALRM.
+
+   ------------------------------------------------------------------------ */
+#define _XOPEN_SOURCE 700
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <usloss.h>
+
+/* -------------------------- Globals ------------------------------------- */
+
+void (*int_vec[NUM_INTS])(int dev, void *unit);
+
+/* the simulated processor status register */
+static volatile unsigned int psr = PSR_CURRENT_MODE;
+
+/* a clock interrupt arrived while interrupts were disabled */
+static volatile sig_atomic_t clock_pending = 0;
+
+/* number of clock interrupts delivered so far */
+static volatile unsigned long clock_ticks = 0;
+
+/* time of the clock device at start of run */
+static struct timespec boot_time;
+
+
+/* -------------------------- Functions ----------------------------------- */
+
+/* ------------------------------------------------------------------------
+   Name - deliver_clock
+   Purpose - Runs the clock interrupt handler the way the hardware would:
+             the current mode and interrupt bits are pushed into the
+             previous bits, the processor enters kernel mode with
+             interrupts disabled, and the old PSR is restored afterwards.
+   Parameters - none
+   Returns - nothing
+   Side Effects - the handler may context switch away
+   ----------------------------------------------------------------------- */
+static void deliver_clock(void)
+{
+   unsigned int saved = psr;
+
+   clock_pending = 0;
+   clock_ticks++;
+   psr = ((saved & (PSR_CURRENT_MODE | PSR_CURRENT_INT)) << 2) |
+         PSR_CURRENT_MODE;
+   if (int_vec[CLOCK_INT] != NULL)
+      int_vec[CLOCK_INT](CLOCK_DEV, NULL);
+   psr = saved;
+} /* deliver_clock */
+
+
+static void clock_signal(int sig)
+{
+   (void) sig;
+   if (psr & PSR_CURRENT_INT)
+      deliver_clock();
+   else
+      clock_pending = 1;
+} /* clock_signal */
+
+
+unsigned int psr_get(void)
+{
+   return psr;
+} /* psr_get */
+
+
+void psr_set(unsigned int new_psr)
+{
+   psr = new_psr;
+   if ((psr & PSR_CURRENT_INT) && clock_pending)
+      deliver_clock();
+} /* psr_set */
+
+
+/* ------------------------------------------------------------------------
+   Name - context_init
+   Purpose - Builds a context that starts executing func on the given
+             stack with the given PSR.
+   Parameters - the context, initial PSR, stack base and size, start
+                function
+   Returns - nothing
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void context_init(context *state, unsigned int new_psr, char *stack,
+                  int stacksize, void (*func)(void))
+{
+   if (getcontext(&state->uc) < 0) {
+      perror("context_init: getcontext");
+      exit(1);
+   }
+   state->uc.uc_stack.ss_sp = stack;
+   state->uc.uc_stack.ss_size = stacksize;
+   state->uc.uc_link = NULL;
+   sigemptyset(&state->uc.uc_sigmask);
+   makecontext(&state->uc, func, 0);
+   state->psr = new_psr;
+} /* context_init */
+
+
+/* ------------------------------------------------------------------------
+   Name - context_switch
+   Purpose - Saves the running context into old (if non-NULL) and resumes
+             new, restoring the PSR that new was saved with.
+   Parameters - old and new contexts
+   Returns - nothing (returns when old is resumed)
+   Side Effects - the machine state is changed
+   ----------------------------------------------------------------------- */
+void context_switch(context *old, context *new)
+{
+   if (old == NULL) {
+      psr = new->psr;
+      setcontext(&new->uc);
+      perror("context_switch: setcontext");
+      exit(1);
+   }
+   old->psr = psr;
+   psr = new->psr;
+   swapcontext(&old->uc, &new->uc);
+} /* context_switch */
+
+
+/* ------------------------------------------------------------------------
+   Name - waitint
+   Purpose - Idles the processor until the next interrupt is handled.
+   Parameters - none
+   Returns - nothing
+   Side Effects - the clock handler runs
+   ----------------------------------------------------------------------- */
+void waitint(void)
+{
+   sigset_t block, wait_mask;
+   unsigned long seen;
+
+   sigemptyset(&block);
+   sigaddset(&block, SIGALRM);
+   sigprocmask(SIG_BLOCK, &block, &wait_mask);
+   sigdelset(&wait_mask, SIGALRM);
+   seen = clock_ticks;
+   while (clock_ticks == seen && !clock_pending)
+      sigsuspend(&wait_mask);
+   sigprocmask(SIG_UNBLOCK, &block, NULL);
+   if (clock_pending && (psr & PSR_CURRENT_INT))
+      deliver_clock();
+} /* waitint */
+
+
+void halt(int dumpcore)
+{
+   finish();
+   fflush(stdout);
+   exit(dumpcore);
+} /* halt */
+
+
+void console(char *fmt, ...)
+{
+   va_list ap;
+
+   va_start(ap, fmt);
+   vfprintf(stdout, fmt, ap);
+   va_end(ap);
+} /* console */
+
+
+/* microseconds since the start of the run */
+int sys_clock(void)
+{
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (int) ((now.tv_sec - boot_time.tv_sec) * 1000000L +
+                 (now.tv_nsec - boot_time.tv_nsec) / 1000);
+} /* sys_clock */
+
+
+int device_input(unsigned int dev, int unit, int *status)
+{
+   if (dev != CLOCK_DEV || unit != 0)
+      return -1;
+   *status = sys_clock();
+   return DEV_OK;
+} /* device_input */
+
+
+int main(void)
+{
+   struct sigaction sa;
+   struct itimerval tick;
+
+   clock_gettime(CLOCK_MONOTONIC, &boot_time);
+
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = clock_signal;
+   sigemptyset(&sa.sa_mask);
+   sa.sa_flags = SA_RESTART;
+   sigaction(SIGALRM, &sa, NULL);
+
+   tick.it_interval.tv_sec = 0;
+   tick.it_interval.tv_usec = CLOCK_MS * 1000;
+   tick.it_value = tick.it_interval;
+   setitimer(ITIMER_REAL, &tick, NULL);
+
+   psr = PSR_CURRENT_MODE;
+   startup();
+
+   /* startup() only returns if it failed to start the first process */
+   halt(1);
+   return 1;
+} /* main */
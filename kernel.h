@@ -1,23 +1,135 @@
-#define DEBUG 0
+/* Non-zero puts a PROT_NONE guard page below every process stack and
+   reports a hit on it as a stack overflow.  Set from the Makefile. */
+#ifndef STACK_GUARD
+#define STACK_GUARD 0
+#endif
+
+/* Non-zero leaves a new process without a stack or context until it is
+   first dispatched.  Set from the Makefile. */
+#ifndef LAZY_CONTEXT
+#define LAZY_CONTEXT 0
+#endif
+
+/* Non-zero makes a process that others wait on in zap() or join() run at
+   the best priority among its waiters, transitively, for as long as they
+   wait.  Set from the Makefile. */
+#ifndef PRIO_INHERIT
+#define PRIO_INHERIT 0
+#endif
+
+/* Time slice of each priority in milliseconds, indexed by priority from 0
+   (EDF_PRIORITY) through SENTINELPRIORITY.  Set from the Makefile. */
+#ifndef QUANTA
+#define QUANTA { 80, 80, 80, 80, 80, 80, 80 }
+#endif
+
+/* Non-zero schedules by stride between process groups: each group gets
+   processor time in proportion to its tickets, and within a group the
+   better priority goes first.  Deadline processes still run ahead of all
+   groups.  Set from the Makefile. */
+#ifndef STRIDE_SCHED
+#define STRIDE_SCHED 0
+#endif
+
+/* Most of the processor, in thousandths, that the deadline processes
+   admitted by fork1_deadline() may reserve between them.  Set from the
+   Makefile. */
+#ifndef EDF_UTIL_LIMIT
+#define EDF_UTIL_LIMIT 900
+#endif
+
+/* size the hot part of a process table entry is laid out for */
+#define CACHE_LINE 64
 
 typedef struct proc_struct proc_struct;
 
 typedef struct proc_struct * proc_ptr;
 
+typedef struct proc_cold proc_cold;
+
+/* FIFO of processes linked through next_proc_ptr.  A process is on at
+   most one: a ready queue, a wait queue, or its parent's zombie list. */
+typedef struct proc_queue {
+   proc_ptr       head;
+   proc_ptr       tail;
+} proc_queue;
+
+/* A process group for stride scheduling: a process given tickets by
+   set_tickets() and its descendants, less any subtree given tickets of
+   its own.  The group lives in its leader's proc_cold; the leader cannot
+   quit before the rest of the group.  With STRIDE_SCHED its members
+   at MAXPRIORITY to MINPRIORITY are queued on the group's own ready
+   queues rather than ReadyList. */
+typedef struct sched_group {
+   int            tickets;
+   int            stride;         /* STRIDE_ONE / tickets */
+   long long      pass;           /* stride times microseconds run */
+   proc_queue     ready[LOWEST_PRIORITY]; /* by priority, from MAXPRIORITY */
+   unsigned int   ready_mask;     /* bit p is set iff ready[p] is non-empty */
+   struct sched_group *next_group; /* next on RunGroups, by pass */
+} sched_group;
+
+/* The fields the scheduler, the wait queues, the wait-for graph search
+   and pid lookup touch, in three cache lines: the first is all that a
+   dispatch and a search visit read, the second holds the family links
+   and wait queues, the third pid lookup and the stride group.
+   Everything else is in the process's proc_cold. */
 struct proc_struct {
-   proc_ptr       next_proc_ptr;
-   proc_ptr       child_proc_ptr;
+   /* first cache line */
+   proc_ptr       next_proc_ptr;  /* next on the same proc_queue, or on
+                                     the free-slot stack if EMPTY */
+   proc_cold     *cold;           /* rarely used fields, in ProcCold */
+   proc_ptr       zap_target;     /* process we are blocked zapping */
+   proc_ptr       next_walk_ptr;  /* wait-for graph search stack */
+   int            pid;            /* process id */
+   int            priority;       /* scheduled at; see base_priority */
+   int            status;         /* READY, BLOCKED, QUIT, etc. */
+   int            slice_start;    /* sys_clock() when last dispatched */
+   int            cpu_time;       /* microseconds run before slice_start */
+   unsigned int   walk_mark;      /* WalkEpoch when last visited */
+   int            unbound;        /* not yet given a stack and context;
+                                     LAZY_CONTEXT only */
+   int            zapped;         /* non-zero once another process zaps us */
+
+   /* second cache line */
+   proc_ptr       child_proc_ptr; /* children that have not quit */
    proc_ptr       next_sibling_ptr;
-   char           name[MAXNAME];     /* process's name */
-   char           start_arg[MAXARG]; /* args passed to process */
+   proc_queue     joiners;        /* blocked in join() for one of our
+                                     children to quit */
+   proc_queue     zappers;        /* blocked in zap() for us to quit */
+   proc_queue     zombies;        /* children that quit but are not yet
+                                     joined, oldest first */
+
+   /* third cache line */
+   proc_ptr       next_hash_ptr;  /* next in the same PidHash bucket */
+   sched_group   *group;          /* stride group, RootGroup by default */
+   int            quit_code;      /* value passed to quit() */
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Per-process data used only at fork, quit, first dispatch, by deadline
+   processes and in reports, kept out of the scheduler's cache lines. */
+struct proc_cold {
    context        state;             /* current context for process */
-   short          pid;               /* process id */
-   int            priority;
-   int (* start_func) (char *);   /* function where process begins -- launch */
-   char          *stack;
+   int (* start_func) (void *);   /* function where process begins -- launch */
+   char          *stack;          /* NULL until first dispatch if
+                                     LAZY_CONTEXT */
    unsigned int   stacksize;
-   int            status;         /* READY, BLOCKED, QUIT, etc. */
-   /* other fields as needed... */
+   int            stack_class;    /* arena size class, or NO_STACK_CLASS */
+   proc_ptr       prev_sibling_ptr;
+   proc_ptr       parent_ptr;
+   int            base_priority;  /* given to fork1(); priority may be
+                                     better while inherited */
+   int            period;         /* deadline processes: period and */
+   int            budget;         /* budget in microseconds, else 0 */
+   int            deadline;       /* sys_clock() time the period ends */
+   int            period_cpu;     /* cpu_time when the period began */
+   int            edf_util;       /* budget / period, in thousandths */
+   proc_ptr       edf_next;       /* next on EdfList */
+   sched_group    own_group;      /* the group this process leads, if any */
+   char          *name;           /* process's name, a string arena copy */
+   void          *start_arg;      /* argument passed to start_func */
+   int            name_class;     /* string arena class of name */
+   int            arg_class;      /* of start_arg, or STR_BORROWED */
 };
 
 struct psr_bits {
@@ -40,3 +152,69 @@ union psr_values {
 #define SENTINELPID 1
 #define SENTINELPRIORITY LOWEST_PRIORITY
 
+/* Deadline processes from fork1_deadline() are scheduled at priority 0,
+   ahead of MAXPRIORITY, earliest deadline first.  One that uses up its
+   budget for a period runs at MINPRIORITY until the next period. */
+#define EDF_PRIORITY 0
+
+/* tickets of the group that processes without a set_tickets() ancestor
+   belong to, and the stride of a group with a single ticket */
+#define STRIDE_TICKETS 100
+#define STRIDE_ONE     (1 << 20)
+
+/* with STRIDE_SCHED, non-zero if a process is queued in its group rather
+   than on ReadyList: all but deadline processes and the sentinel */
+#define GROUP_QUEUED(proc) ((proc)->priority != EDF_PRIORITY && \
+                            (proc)->priority != SENTINELPRIORITY)
+
+/* Process table geometry.  The table grows PROC_CHUNK entries at a time,
+   up to PROC_LIMIT, and entries never move once allocated.  Pids are
+   not tied to slots; they resolve through a hash of PROC_LIMIT buckets.
+   Set PROC_LIMIT from the Makefile to run more than MAXPROC processes at
+   once. */
+#ifndef PROC_LIMIT
+#define PROC_LIMIT MAXPROC
+#endif
+#define PROC_CHUNK    64
+#define PROC_SEGMENTS ((PROC_LIMIT + PROC_CHUNK - 1) / PROC_CHUNK)
+#define PID_HASH_SIZE PROC_LIMIT
+#define PID_MAX       INT_MAX
+
+/* the process table entry for a slot, 0 <= slot < PROC_LIMIT; its cold
+   half is at the same position in ProcCold */
+#define PROC_SLOT(slot) (&ProcTable[(slot) / PROC_CHUNK][(slot) % PROC_CHUNK])
+
+/* Stack arena size classes.  Class c holds STACK_CLASS_COUNT(c) stacks of
+   STACK_CLASS_SIZE(c) bytes, carved out of one allocation at startup.
+   Larger requests, or any made once the fitting classes are used up, fall
+   back to malloc() and are marked NO_STACK_CLASS. */
+#define STACK_CLASSES 2
+#define STACK_CLASS_SIZE(c)  (((c) + 1) * USLOSS_MIN_STACK)
+#define STACK_CLASS_COUNT(c) ((c) == 0 ? MAXPROC : MAXPROC / 4)
+#define NO_STACK_CLASS -1
+
+/* String arena size classes for the copies fork1() keeps of process names
+   and arguments.  Class c holds strings of up to STR_CLASS_SIZE(c) bytes,
+   including the terminator, in STR_SLAB-byte slabs malloc'd as a class
+   runs dry.  Longer strings are malloc'd and marked NO_STR_CLASS; an
+   argument handed over by fork1_ptr() is not ours and is STR_BORROWED. */
+#define STR_CLASSES 4
+#define STR_CLASS_SIZE(c) (16 << (c))
+#define STR_SLAB     2048
+#define NO_STR_CLASS -1
+#define STR_BORROWED -2
+
+/* Process status values.  block_me() statuses must be larger than 10. */
+#define EMPTY          0
+#define READY          1
+#define RUNNING        2
+#define QUIT           3
+#define JOIN_BLOCKED   4
+#define ZAP_BLOCKED    5
+#define MAX_KERNEL_STATUS 10
+
+/* The process table, the running process and an O(1) pid to priority
+   lookup, for p1.c. */
+extern proc_ptr ProcTable[PROC_SEGMENTS];
+extern proc_ptr Current;
+extern int get_priority(int pid);
@@ -1,11 +1,24 @@
+#include <stddef.h>
+#include <phase1.h>
+#include "kernel.h"
+#include "trace.h"
+
 void
 p1_fork(int pid)
-{}
+{
+   trace_event(TRACE_FORK, pid, get_priority(pid),
+               Current == NULL ? -1 : Current->pid,
+               Current == NULL ? -1 : Current->priority);
+}
 
 void
 p1_switch(int old, int new)
-{}
+{
+   trace_event(TRACE_SWITCH, old, get_priority(old), new, get_priority(new));
+}
 
 void
 p1_quit(int pid)
-{}
+{
+   trace_event(TRACE_QUIT, pid, get_priority(pid), -1, -1);
+}
@@ -4,36 +4,170 @@
    CSCV 452
 
    ------------------------------------------------------------------------ */
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <stdio.h>
 #include <phase1.h>
+#include "phase1ext.h"
 #include "kernel.h"
+#include "trace.h"
+#if STACK_GUARD
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 /* ------------------------- Prototypes ----------------------------------- */
-int sentinel (void *);
+int sentinel (char *);
 extern int start1 (char *);
 void dispatcher(void);
 void launch();
+void disableInterrupts();
 static void enableInterrupts();
+static void clock_handler(int dev, void *unit);
+static void check_kernel_mode(char *caller);
 static void check_deadlock();
+static void report_blocked(void);
+static int wait_can_finish(proc_ptr proc);
+static void walk_push(proc_ptr *walk, proc_ptr proc);
+static void queue_push(proc_queue *queue, proc_ptr proc);
+static proc_ptr queue_pop(proc_queue *queue);
+static void queue_push_head(proc_queue *queue, proc_ptr proc);
+static void queue_remove(proc_queue *queue, proc_ptr proc);
+static void ready_push_tail(proc_ptr proc);
+static void ready_push_head(proc_ptr proc);
+static proc_ptr ready_pop(void);
+static int ready_best_priority(void);
+static void wait_on(proc_queue *queue, int status);
+static void wake_all(proc_queue *queue);
+static void wake_one(proc_ptr proc);
+#if PRIO_INHERIT
+static void inherit_priority(proc_ptr proc);
+static void inherit_children(proc_ptr parent);
+static void ready_push_ranked(proc_ptr proc);
+#endif
+static void ready_remove(proc_ptr proc);
+static int ready_outranks(proc_ptr proc);
+static void set_base_priority(proc_ptr proc, int priority);
+static void change_priority(proc_ptr proc, int priority);
+static void edf_insert(proc_ptr proc, int ahead);
+static void edf_admit(proc_ptr proc, int period, int budget, int util);
+static void edf_retire(proc_ptr proc);
+static void edf_tick(void);
+static void group_move(proc_ptr proc, sched_group *from, sched_group *to);
+static void group_clear(sched_group *group);
+#if STRIDE_SCHED
+static void group_push(proc_ptr proc, int ahead);
+static void group_remove(proc_ptr proc);
+static proc_ptr group_pop(void);
+static void group_charge(sched_group *group, int usec);
+static void group_link(sched_group *group);
+static void group_unlink(sched_group *group);
+#endif
+static proc_ptr find_proc(int pid);
+static int join_wait(char *caller);
+static int reap_zombie(int *code);
+static proc_ptr alloc_slot(void);
+static int grow_table(void);
+static void release_slot(proc_ptr proc);
+static void context_bind(proc_ptr proc);
+static void stack_arena_init(void);
+static char *stack_alloc(int stacksize, int *stack_class);
+static void stack_free(char *stack, int stacksize, int stack_class);
+static char *str_copy(const char *str, int *str_class);
+static void str_free(char *str, int str_class);
+static int fork_common(char *name, int (*f)(void *), void *arg, int copy_arg,
+                       int stacksize, int priority);
+static int fork_proc(char *name, int (*f)(void *), void *arg, int copy_arg,
+                     int stacksize, int priority);
+#if STACK_GUARD
+static void stack_guard_init(void);
+static void stack_overflow_handler(int sig, siginfo_t *info, void *uc);
+#endif
 
 
 /* -------------------------- Globals ------------------------------------- */
 
-/* Patrick's debugging global variable... */
-int debugflag = 1;
+/* the process table, PROC_CHUNK entries per segment; see PROC_SLOT() */
+proc_ptr ProcTable[PROC_SEGMENTS];
 
-/* the process table */
-proc_struct ProcTable[MAXPROC];
+/* the cold halves of the process table entries, segment for segment */
+static proc_cold *ProcCold[PROC_SEGMENTS];
+
+/* slots allocated so far */
+static int ProcSlots;
+
+/* EMPTY slots, linked through next_proc_ptr */
+static proc_ptr FreeSlots;
+
+/* live and unjoined processes by pid, chained through next_hash_ptr */
+static proc_ptr PidHash[PID_HASH_SIZE];
 
 /* Process lists  */
 
+/* free stacks of each arena size class, linked through their first word */
+static char *StackFree[STACK_CLASSES];
+
+/* free strings of each string arena class, linked the same way */
+static char *StrFree[STR_CLASSES];
+
+#if STACK_GUARD
+/* size of the PROT_NONE page below every stack */
+static size_t GuardSize;
+
+/* the SIGSEGV handler cannot run on the stack that just overflowed */
+static char GuardSignalStack[64 * 1024];
+#endif
+
+/* ready queues indexed by priority, MAXPRIORITY through SENTINELPRIORITY;
+   with STRIDE_SCHED only EDF_PRIORITY and the sentinel's are used, and
+   other processes are queued in their groups */
+static proc_queue ReadyList[SENTINELPRIORITY + 1];
+
+/* bit p is set iff ReadyList[p] is non-empty */
+static unsigned int ReadyMask;
+
+/* time slice of each priority in microseconds, filled in by startup() */
+static const int QuantumMs[SENTINELPRIORITY + 1] = QUANTA;
+static int Quantum[SENTINELPRIORITY + 1];
+
+/* Process counts kept up to date as processes change state, so that
+   check_deadlock() is O(1).  None of them include the sentinel. */
+static int LiveCount;      /* forked and not yet quit */
+static int ReadyCount;     /* on a ready queue */
+static int BlockedCount;   /* in join(), zap() or block_me() */
+
+/* processes admitted by fork1_deadline() that have not quit, linked
+   through edf_next, and the thousandths of the processor they reserve */
+static proc_ptr EdfList;
+static int EdfUtil;
+
+/* the stride group of the processes outside every set_tickets() subtree */
+static sched_group RootGroup;
+
+#if STRIDE_SCHED
+/* groups with a ready process, linked through next_group in pass order */
+static sched_group *RunGroups;
+
+/* pass of the group picked last.  A group that was idle starts again no
+   lower, so it cannot claim the time it was not asking for. */
+static long long GlobalPass;
+#endif
+
+/* a process just woken that the next dispatch switches to directly; it
+   is READY but on no ready queue.  See wake_one(). */
+static proc_ptr Handoff;
+
+/* bumped for every wait-for graph search; marks visited processes */
+static unsigned int WalkEpoch;
+
 /* current process ID */
 proc_ptr Current;
 
-/* the next pid to be assigned */
-unsigned int next_pid = SENTINELPID;
+/* the next pid to be given out by alloc_slot() */
+static int next_pid = SENTINELPID;
 
 
 /* -------------------------- Functions ----------------------------------- */
@@ -50,29 +184,60 @@ void startup()
    int i;      /* loop index */
    int result; /* value returned by call to fork1() */
 
-   /* initialize the process table */
+   /* the process table starts empty and grows as fork1() needs it */
+   for (i = 0; i < PROC_SEGMENTS; i++) {
+      ProcTable[i] = NULL;
+      ProcCold[i] = NULL;
+   }
+   for (i = 0; i < STR_CLASSES; i++)
+      StrFree[i] = NULL;
+   for (i = 0; i < PID_HASH_SIZE; i++)
+      PidHash[i] = NULL;
+   ProcSlots = 0;
+   FreeSlots = NULL;
+   Current = NO_CURRENT_PROCESS;
+   Handoff = NULL;
+   EdfList = NULL;
+   EdfUtil = 0;
+   RootGroup.tickets = STRIDE_TICKETS;
+   RootGroup.stride = STRIDE_ONE / STRIDE_TICKETS;
+   RootGroup.pass = 0;
+   group_clear(&RootGroup);
+#if STRIDE_SCHED
+   RunGroups = NULL;
+   GlobalPass = 0;
+#endif
+   LiveCount = ReadyCount = BlockedCount = 0;
+   stack_arena_init();
 
    /* Initialize the Ready list, etc. */
-   if (DEBUG && debugflag)
-      console("startup(): initializing the Ready & Blocked lists\n");
-   ReadyList = NULL;
+   trace_log(TRACE_CAT_BOOT, TRACE_INFO,
+             "startup(): initializing the Ready & Blocked lists\n");
+   for (i = 0; i <= SENTINELPRIORITY; i++) {
+      ReadyList[i].head = NULL;
+      ReadyList[i].tail = NULL;
+   }
+   ReadyMask = 0;
 
    /* Initialize the clock interrupt handler */
+   for (i = 0; i <= SENTINELPRIORITY; i++)
+      Quantum[i] = QuantumMs[i] * 1000;
+   int_vec[CLOCK_INT] = clock_handler;
 
    /* startup a sentinel process */
-   if (DEBUG && debugflag)
-       console("startup(): calling fork1() for sentinel\n");
+   trace_log(TRACE_CAT_BOOT, TRACE_INFO,
+             "startup(): calling fork1() for sentinel\n");
    result = fork1("sentinel", sentinel, NULL, USLOSS_MIN_STACK,
                    SENTINELPRIORITY);
    if (result < 0) {
-      if (DEBUG && debugflag)
-         console("startup(): fork1 of sentinel returned error, halting...\n");
+      trace_log(TRACE_CAT_BOOT, TRACE_INFO,
+                "startup(): fork1 of sentinel returned error, halting...\n");
       halt(1);
    }
-  
+
    /* start the test process */
-   if (DEBUG && debugflag)
-      console("startup(): calling fork1() for start1\n");
+   trace_log(TRACE_CAT_BOOT, TRACE_INFO,
+             "startup(): calling fork1() for start1\n");
    result = fork1("start1", start1, NULL, 2 * USLOSS_MIN_STACK, 1);
    if (result < 0) {
       console("startup(): fork1 for start1 returned an error, halting...\n");
@@ -94,8 +259,9 @@ void startup()
    ----------------------------------------------------------------------- */
 void finish()
 {
-   if (DEBUG && debugflag)
-      console("in finish...\n");
+   trace_log(TRACE_CAT_BOOT, TRACE_INFO, "in finish...\n");
+   trace_flush();
+   trace_save();
 } /* finish */
 
 /* ------------------------------------------------------------------------
@@ -107,49 +273,246 @@ void finish()
                 the priority to be assigned to the child process.
    Returns - the process id of the created child or -1 if no child could
              be created or if priority is not between max and min priority.
+             -2 if the stack size is smaller than USLOSS_MIN_STACK.
    Side Effects - ReadyList is changed, ProcTable is changed, Current
                   process information changed
    ------------------------------------------------------------------------ */
-int fork1(char *name, int (*f)(void *), void *arg, int stacksize, int priority)
+int fork1(char *name, int (*f)(char *), char *arg, int stacksize, int priority)
+{
+   return fork_common(name, (int (*)(void *)) f, arg, 1, stacksize, priority);
+} /* fork1 */
+
+
+/* ------------------------------------------------------------------------
+   Name - fork1_ptr
+   Purpose - Like fork1(), but hands arg to the child as is instead of
+             copying it, so the argument may be any object of any size.
+             The caller keeps it alive until the child is done with it.
+   Parameters - as for fork1(), with an opaque argument
+   Returns - as for fork1()
+   Side Effects - as for fork1()
+   ------------------------------------------------------------------------ */
+int fork1_ptr(char *name, int (*f)(void *), void *arg, int stacksize,
+              int priority)
+{
+   return fork_common(name, f, arg, 0, stacksize, priority);
+} /* fork1_ptr */
+
+
+/* ------------------------------------------------------------------------
+   Name - fork1_deadline
+   Purpose - Creates a deadline process.  It runs ahead of every fixed
+             priority process, earliest deadline first, for up to budget
+             ms of every period ms, and at MINPRIORITY for the rest of
+             the period once the budget is used up.  It is admitted only
+             if the budgets of all deadline processes then add up to at
+             most EDF_UTIL_LIMIT thousandths of the processor.
+   Parameters - as for fork1(), with a period and budget in milliseconds
+                in place of the priority
+   Returns - as for fork1(); -1 also if budget is not between 1 and period,
+             checked before admission.
+             -3 if admitting the process would overcommit the processor.
+   Side Effects - as for fork1()
+   ------------------------------------------------------------------------ */
+int fork1_deadline(char *name, int (*f)(char *), char *arg, int stacksize,
+                   int period, int budget)
+{
+   int pid, util;
+
+   check_kernel_mode("fork1_deadline");
+   disableInterrupts();
+
+   if (name == NULL || f == NULL ||
+       period <= 0 || budget <= 0 || budget > period) {
+      enableInterrupts();
+      return -1;
+   }
+   util = (int) (((long long) budget * 1000 + period - 1) / period);
+   if (EdfUtil + util > EDF_UTIL_LIMIT) {
+      trace_log(TRACE_CAT_FORK, TRACE_INFO, "fork1_deadline(): %s needs "
+                "%d/1000, %d/1000 left\n", name, util,
+                EDF_UTIL_LIMIT - EdfUtil);
+      enableInterrupts();
+      return -3;
+   }
+
+   pid = fork_proc(name, (int (*)(void *)) f, arg, 1, stacksize,
+                   MINPRIORITY);
+   if (pid > 0) {
+      edf_admit(find_proc(pid), period, budget, util);
+      dispatcher();
+   }
+
+   enableInterrupts();
+   return pid;
+} /* fork1_deadline */
+
+
+/* ------------------------------------------------------------------------
+   Name - fork_many
+   Purpose - Creates a batch of processes in one critical section, with
+             one dispatch decision after the last of them, so launching a
+             pool of workers pays for the mode check and the preemption
+             check once rather than once per child.
+   Parameters - count specs, each a fork1_ptr() argument list; an array
+                of count ints for the results, or NULL
+   Returns - the number of processes created, or -1 if specs is NULL or
+             count is negative.  pids[i] is the pid of the child made from
+             specs[i], or what fork1_ptr() would have returned for it.
+   Side Effects - as for count calls of fork1_ptr()
+   ------------------------------------------------------------------------ */
+int fork_many(fork_spec *specs, int count, int *pids)
 {
-   int proc_slot;
+   int i, pid;
+   int created = 0;
+
+   check_kernel_mode("fork_many");
+   if (specs == NULL || count < 0)
+      return -1;
+   disableInterrupts();
+
+   for (i = 0; i < count; i++) {
+      pid = fork_proc(specs[i].name, specs[i].func, specs[i].arg, 0,
+                      specs[i].stacksize, specs[i].priority);
+      if (pid > 0)
+         created++;
+      if (pids != NULL)
+         pids[i] = pid;
+   }
+
+   if (created > 0)
+      dispatcher();
 
-   if (DEBUG && debugflag)
-      console("fork1(): creating process %s\n", name);
+   enableInterrupts();
+   return created;
+} /* fork_many */
+
+
+/* ------------------------------------------------------------------------
+   Name - fork_common
+   Purpose - Does the work of fork1() and fork1_ptr().
+   Parameters - as for fork1(); copy_arg is non-zero if arg is a string
+                to be copied into the string arena
+   Returns - as for fork1()
+   Side Effects - as for fork1()
+   ------------------------------------------------------------------------ */
+static int fork_common(char *name, int (*f)(void *), void *arg, int copy_arg,
+                       int stacksize, int priority)
+{
+   int pid;
 
    /* test if in kernel mode; halt if in user mode */
+   check_kernel_mode("fork1");
+   disableInterrupts();
+
+   pid = fork_proc(name, f, arg, copy_arg, stacksize, priority);
+
+   /* the sentinel is created before there is anything to switch from */
+   if (pid > 0 && f != (int (*)(void *)) sentinel)
+      dispatcher();
+
+   enableInterrupts();
+   return pid;
+} /* fork_common */
+
+
+/* ------------------------------------------------------------------------
+   Name - fork_proc
+   Purpose - Creates a process and puts it on the ready list, without
+             running the dispatcher.
+   Parameters - as for fork_common()
+   Returns - as for fork1()
+   Side Effects - ReadyList is changed, ProcTable is changed, Current
+                  process information changed
+   ------------------------------------------------------------------------ */
+static int fork_proc(char *name, int (*f)(void *), void *arg, int copy_arg,
+                     int stacksize, int priority)
+{
+   proc_ptr proc;
 
    /* Return if stack size is too small */
+   if (stacksize < USLOSS_MIN_STACK)
+      return -2;
+
+   /* only the sentinel may run at the sentinel's priority */
+   if (name == NULL || f == NULL ||
+       ((priority < MAXPRIORITY || priority > MINPRIORITY) &&
+        !(f == (int (*)(void *)) sentinel && priority == SENTINELPRIORITY)))
+      return -1;
+
+   trace_log(TRACE_CAT_FORK, TRACE_INFO,
+             "fork1(): creating process %s\n", name);
 
    /* find an empty slot in the process table */
+   proc = alloc_slot();
+   if (proc == NULL) {
+      trace_log(TRACE_CAT_FORK, TRACE_INFO, "fork1(): process table full\n");
+      return -1;
+   }
 
    /* fill-in entry in process table */
    if ( strlen(name) >= (MAXNAME - 1) ) {
       console("fork1(): Process name is too long.  Halting...\n");
       halt(1);
    }
-   strcpy(ProcTable[proc_slot].name, name);
-   ProcTable[proc_slot].start_func = f;
-   if ( arg == NULL )
-      ProcTable[proc_slot].start_arg[0] = '\0';
+   proc->cold->name = str_copy(name, &proc->cold->name_class);
+   proc->cold->start_func = f;
+   if (!copy_arg)
+      proc->cold->start_arg = arg;
+   else if (arg == NULL)
+      proc->cold->start_arg = "";
    else if ( strlen(arg) >= (MAXARG - 1) ) {
       console("fork1(): argument too long.  Halting...\n");
       halt(1);
    }
    else
-      strcpy(ProcTable[proc_slot].start_arg, arg);
+      proc->cold->start_arg = str_copy(arg, &proc->cold->arg_class);
+   if (!copy_arg || arg == NULL)
+      proc->cold->arg_class = STR_BORROWED;
 
-   /* Initialize context for this process, but use launch function pointer for
-    * the initial value of the process's program counter (PC)
-    */
-   context_init(&(ProcTable[proc_slot].state), psr_get(),
-                ProcTable[proc_slot].stack, 
-                ProcTable[proc_slot].stacksize, launch);
+   proc->priority = proc->cold->base_priority = priority;
+   proc->cold->period = proc->cold->budget = 0;
+   proc->group = Current == NULL ? &RootGroup : Current->group;
+   proc->next_proc_ptr = NULL;
+   proc->child_proc_ptr = NULL;
+   proc->next_sibling_ptr = NULL;
+   proc->cold->prev_sibling_ptr = NULL;
+   proc->cold->parent_ptr = Current;
+   proc->quit_code = 0;
+   proc->zapped = 0;
+   proc->zap_target = NULL;
+   proc->joiners.head = proc->joiners.tail = NULL;
+   proc->zappers.head = proc->zappers.tail = NULL;
+   proc->zombies.head = proc->zombies.tail = NULL;
+   proc->walk_mark = 0;
+   proc->slice_start = 0;
+   proc->cpu_time = 0;
+   proc->cold->stack = NULL;
+   proc->cold->stacksize = stacksize;
+   proc->unbound = 1;
+
+   /* link the new process onto its parent's child list */
+   if (Current != NULL) {
+      proc->next_sibling_ptr = Current->child_proc_ptr;
+      if (Current->child_proc_ptr != NULL)
+         Current->child_proc_ptr->cold->prev_sibling_ptr = proc;
+      Current->child_proc_ptr = proc;
+   }
+
+#if !LAZY_CONTEXT
+   context_bind(proc);
+#endif
 
    /* for future phase(s) */
-   p1_fork(ProcTable[proc_slot].pid);
+   p1_fork(proc->pid);
 
-} /* fork1 */
+   proc->status = READY;
+   ready_push_tail(proc);
+   if (f != (int (*)(void *)) sentinel)
+      LiveCount++;
+
+   return proc->pid;
+} /* fork_proc */
 
 /* ------------------------------------------------------------------------
    Name - launch
@@ -163,17 +526,16 @@ void launch()
 {
    int result;
 
-   if (DEBUG && debugflag)
-      console("launch(): started\n");
+   trace_log(TRACE_CAT_FORK, TRACE_VERBOSE, "launch(): started\n");
 
    /* Enable interrupts */
    enableInterrupts();
 
    /* Call the function passed to fork1, and capture its return value */
-   result = Current->start_func(Current->start_arg);
+   result = Current->cold->start_func(Current->cold->start_arg);
 
-   if (DEBUG && debugflag)
-      console("Process %d returned to launch\n", Current->pid);
+   trace_log(TRACE_CAT_FORK, TRACE_INFO,
+             "Process %d returned to launch\n", Current->pid);
 
    quit(result);
 
@@ -182,21 +544,163 @@ void launch()
 
 /* ------------------------------------------------------------------------
    Name - join
-   Purpose - Wait for a child process (if one has been forked) to quit.  If 
+   Purpose - Wait for a child process (if one has been forked) to quit.  If
              one has already quit, don't wait.
-   Parameters - a pointer to an int where the termination code of the 
+   Parameters - a pointer to an int where the termination code of the
                 quitting process is to be stored.
    Returns - the process id of the quitting child joined on.
 		-1 if the process was zapped in the join
 		-2 if the process has no children
-   Side Effects - If no child process has quit before join is called, the 
+   Side Effects - If no child process has quit before join is called, the
                   parent is removed from the ready list and blocked.
+                  The joined child's slot is freed.
    ------------------------------------------------------------------------ */
 int join(int *code)
 {
+   int child_pid;
+
+   check_kernel_mode("join");
+   disableInterrupts();
+
+   if (join_wait("join") < 0) {
+      enableInterrupts();
+      return -2;
+   }
+   child_pid = reap_zombie(code);
+
+   enableInterrupts();
+   return Current->zapped ? -1 : child_pid;
 } /* join */
 
 
+/* ------------------------------------------------------------------------
+   Name - join_all
+   Purpose - Joins every child that has quit, in the order they quit,
+             waiting only if none has quit yet.  A parent of many children
+             pays for one kernel entry and at most one block per batch.
+   Parameters - arrays of max entries for the pids and termination codes
+                of the children joined
+   Returns - the number of children joined, 1 through max.
+		-1 if the process was zapped in the join_all, or max < 1;
+		   no child is joined then
+		-2 if the process has no children
+   Side Effects - as for join(), once per child joined
+   ------------------------------------------------------------------------ */
+int join_all(int *pids, int *codes, int max)
+{
+   int count;
+
+   check_kernel_mode("join_all");
+   if (pids == NULL || codes == NULL || max < 1)
+      return -1;
+   disableInterrupts();
+
+   if (join_wait("join_all") < 0) {
+      enableInterrupts();
+      return -2;
+   }
+   if (Current->zapped) {
+      enableInterrupts();
+      return -1;
+   }
+   for (count = 0; count < max && Current->zombies.head != NULL; count++)
+      pids[count] = reap_zombie(&codes[count]);
+
+   enableInterrupts();
+   return count;
+} /* join_all */
+
+
+/* ------------------------------------------------------------------------
+   Name - try_join
+   Purpose - Joins the child that quit first, if any has, without waiting.
+   Parameters - where to store the termination code of the child joined
+   Returns - the process id of the child joined.
+		0 if no child has quit yet
+		-1 if the process has been zapped; no child is joined then
+		-2 if the process has no children
+   Side Effects - the joined child's slot is freed
+   ------------------------------------------------------------------------ */
+int try_join(int *code)
+{
+   int child_pid = 0;
+
+   check_kernel_mode("try_join");
+   disableInterrupts();
+
+   if (Current->zombies.head == NULL && Current->child_proc_ptr == NULL) {
+      enableInterrupts();
+      return -2;
+   }
+   if (Current->zapped) {
+      enableInterrupts();
+      return -1;
+   }
+   if (Current->zombies.head != NULL)
+      child_pid = reap_zombie(code);
+
+   enableInterrupts();
+   return child_pid;
+} /* try_join */
+
+
+/* ------------------------------------------------------------------------
+   Name - join_wait
+   Purpose - Blocks the current process until one of its children has
+             quit, halting instead if none of them ever can.
+   Parameters - name of the calling kernel function, for the halt message
+   Returns - 0 once the zombie list is non-empty, -2 if the process has
+             no children
+   Side Effects - may block and dispatch; interrupts must be disabled
+   ------------------------------------------------------------------------ */
+static int join_wait(char *caller)
+{
+   proc_ptr child;
+   int can_finish;
+
+   if (Current->zombies.head == NULL && Current->child_proc_ptr == NULL)
+      return -2;
+
+   /* no child has quit yet; wait for one */
+   while (Current->zombies.head == NULL) {
+      can_finish = 0;
+      WalkEpoch++;
+      for (child = Current->child_proc_ptr; child != NULL && !can_finish;
+           child = child->next_sibling_ptr)
+         can_finish = wait_can_finish(child);
+      if (!can_finish) {
+         console("%s(): process %d would wait forever on its children.  "
+                 "Halting...\n", caller, Current->pid);
+         report_blocked();
+         halt(1);
+      }
+      wait_on(&Current->joiners, JOIN_BLOCKED);
+#if PRIO_INHERIT
+      inherit_children(Current);
+#endif
+      dispatcher();
+   }
+   return 0;
+} /* join_wait */
+
+
+/* takes the oldest zombie off the current process's list and frees its
+   slot; returns its pid and stores its termination code */
+static int reap_zombie(int *code)
+{
+   proc_ptr child;
+   int child_pid;
+
+   child = queue_pop(&Current->zombies);
+   *code = child->quit_code;
+   child_pid = child->pid;
+   trace_log(TRACE_CAT_JOIN, TRACE_INFO, "join(): process %d joined %d, "
+             "status %d\n", Current->pid, child_pid, *code);
+   release_slot(child);
+   return child_pid;
+} /* reap_zombie */
+
+
 /* ------------------------------------------------------------------------
    Name - quit
    Purpose - Stops the child process and notifies the parent of the death by
@@ -208,68 +712,1598 @@ int join(int *code)
    ------------------------------------------------------------------------ */
 void quit(int code)
 {
+   proc_ptr child, parent, prev;
+
+   check_kernel_mode("quit");
+   disableInterrupts();
+
+   if (Current->child_proc_ptr != NULL) {
+      console("quit(): process %d quit with active children. Halting...\n",
+              Current->pid);
+      halt(1);
+   }
+
+   /* nobody is left to join our children that have already quit */
+   while ((child = queue_pop(&Current->zombies)) != NULL)
+      release_slot(child);
+
+   trace_log(TRACE_CAT_JOIN, TRACE_INFO, "quit(): process %d, status %d\n",
+             Current->pid, code);
+   Current->quit_code = code;
+   Current->status = QUIT;
+   LiveCount--;
+   if (Current->cold->period != 0)
+      edf_retire(Current);
+
+   /* move from the parent's live children to its zombies */
+   parent = Current->cold->parent_ptr;
+   if (parent != NULL) {
+      prev = Current->cold->prev_sibling_ptr;
+      if (prev == NULL)
+         parent->child_proc_ptr = Current->next_sibling_ptr;
+      else
+         prev->next_sibling_ptr = Current->next_sibling_ptr;
+      if (Current->next_sibling_ptr != NULL)
+         Current->next_sibling_ptr->cold->prev_sibling_ptr = prev;
+      queue_push(&parent->zombies, Current);
+#if PRIO_INHERIT
+      if (parent->status == JOIN_BLOCKED) {
+         wake_all(&parent->joiners);
+         inherit_children(parent);
+      }
+#else
+      wake_all(&parent->joiners);
+#endif
+   }
+   wake_all(&Current->zappers);
+
    p1_quit(Current->pid);
+
+   dispatcher();
 } /* quit */
 
 
+/* ------------------------------------------------------------------------
+   Name - zap
+   Purpose - Marks a process as zapped and waits for it to quit.
+   Parameters - pid of the process to zap
+   Returns - 0 once the zapped process has quit
+             -1 if the calling process was itself zapped while in zap
+   Side Effects - halts if pid is the caller or does not exist
+   ------------------------------------------------------------------------ */
+int zap(int pid)
+{
+   proc_ptr target;
+
+   check_kernel_mode("zap");
+   disableInterrupts();
+
+   if (pid == Current->pid) {
+      console("zap(): process %d tried to zap itself.  Halting...\n", pid);
+      halt(1);
+   }
+
+   target = find_proc(pid);
+   if (target == NULL) {
+      console("zap(): process being zapped does not exist.  Halting...\n");
+      halt(1);
+   }
+
+   trace_log(TRACE_CAT_ZAP, TRACE_INFO, "zap(): process %d zapping %d\n",
+             Current->pid, pid);
+   target->zapped = 1;
+   if (target->status != QUIT) {
+      WalkEpoch++;
+      if (!wait_can_finish(target)) {
+         console("zap(): process %d zapping process %d would deadlock.  "
+                 "Halting...\n", Current->pid, pid);
+         report_blocked();
+         halt(1);
+      }
+      Current->zap_target = target;
+      wait_on(&target->zappers, ZAP_BLOCKED);
+#if PRIO_INHERIT
+      inherit_priority(target);
+#endif
+      dispatcher();
+      Current->zap_target = NULL;
+   }
+
+   enableInterrupts();
+   return Current->zapped ? -1 : 0;
+} /* zap */
+
+
+/* ------------------------------------------------------------------------
+   Name - is_zapped
+   Purpose - Reports whether the current process has been zapped.
+   Parameters - none
+   Returns - non-zero if zapped, 0 otherwise
+   Side Effects - none
+   ------------------------------------------------------------------------ */
+int is_zapped(void)
+{
+   return Current->zapped;
+} /* is_zapped */
+
+
+int getpid(void)
+{
+   return Current->pid;
+} /* getpid */
+
+
+/* ------------------------------------------------------------------------
+   Name - get_priority
+   Purpose - Looks up the priority of a process, for the p1.c hooks.
+   Parameters - the pid
+   Returns - the priority, or -1 if no live or unjoined process has that pid
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+int get_priority(int pid)
+{
+   proc_ptr proc = find_proc(pid);
+
+   return proc == NULL ? -1 : proc->priority;
+} /* get_priority */
+
+
+/* ------------------------------------------------------------------------
+   Name - block_me
+   Purpose - Blocks the current process with the given status.
+   Parameters - the block status, which must be larger than 10
+   Returns - -1 if zapped while blocked, 0 otherwise
+   Side Effects - the current process is taken off the processor
+   ------------------------------------------------------------------------ */
+int block_me(int new_status)
+{
+   check_kernel_mode("block_me");
+   disableInterrupts();
+
+   if (new_status <= MAX_KERNEL_STATUS) {
+      console("block_me(): new_status %d must be larger than %d. Halting...\n",
+              new_status, MAX_KERNEL_STATUS);
+      halt(1);
+   }
+
+   trace_log(TRACE_CAT_ZAP, TRACE_INFO, "block_me(): process %d, status %d\n",
+             Current->pid, new_status);
+   Current->status = new_status;
+   BlockedCount++;
+   dispatcher();
+
+   enableInterrupts();
+   return Current->zapped ? -1 : 0;
+} /* block_me */
+
+
+/* ------------------------------------------------------------------------
+   Name - unblock_proc
+   Purpose - Makes a process blocked in block_me() ready again.
+   Parameters - pid of the process to unblock
+   Returns - -2 if pid is not blocked in block_me() or is the caller,
+             -1 if the caller was zapped, 0 otherwise
+   Side Effects - the dispatcher is called
+   ------------------------------------------------------------------------ */
+int unblock_proc(int pid)
+{
+   proc_ptr proc;
+
+   check_kernel_mode("unblock_proc");
+   disableInterrupts();
+
+   proc = find_proc(pid);
+   if (proc == NULL || proc == Current ||
+       proc->status <= MAX_KERNEL_STATUS) {
+      enableInterrupts();
+      return -2;
+   }
+
+   trace_log(TRACE_CAT_ZAP, TRACE_INFO, "unblock_proc(): process %d\n", pid);
+   wake_one(proc);
+   dispatcher();
+
+   enableInterrupts();
+   return Current->zapped ? -1 : 0;
+} /* unblock_proc */
+
+
+/* ------------------------------------------------------------------------
+   Name - read_cur_start_time, readtime
+   Purpose - CPU accounting for the current process.  read_cur_start_time
+             is the sys_clock() time at which its current slice began;
+             readtime is the CPU time it has used in total, in
+             milliseconds, including the current slice.  readtime reads
+             the clock and the slice start with interrupts disabled, so
+             a clock tick cannot end the slice in between.
+   ------------------------------------------------------------------------ */
+int read_cur_start_time(void)
+{
+   return Current->slice_start;
+} /* read_cur_start_time */
+
+
+int readtime(void)
+{
+   unsigned int old_psr = psr_get();
+   int cpu_time;
+
+   check_kernel_mode("readtime");
+   disableInterrupts();
+   cpu_time = Current->cpu_time + sys_clock() - Current->slice_start;
+   psr_set(old_psr);
+   return cpu_time / 1000;
+} /* readtime */
+
+
+/* ------------------------------------------------------------------------
+   Name - dump_processes
+   Purpose - Prints the process table for debugging, with interrupts
+             disabled so that it is a consistent snapshot.
+   Parameters - none
+   Returns - nothing
+   Side Effects - none
+   ------------------------------------------------------------------------ */
+void dump_processes(void)
+{
+   unsigned int old_psr = psr_get();
+   int i, kids, cpu_time;
+   proc_ptr proc, child, parent;
+
+   check_kernel_mode("dump_processes");
+   disableInterrupts();
+   console("PID\tParent\tPriority\tStatus\t\t# Kids\tCPUtime\tName\n");
+   for (i = 0; i < ProcSlots; i++) {
+      proc = PROC_SLOT(i);
+      if (proc->status == EMPTY)
+         continue;
+      kids = 0;
+      for (child = proc->child_proc_ptr; child != NULL;
+           child = child->next_sibling_ptr)
+         kids++;
+      for (child = proc->zombies.head; child != NULL;
+           child = child->next_proc_ptr)
+         kids++;
+      parent = proc->cold->parent_ptr;
+      console("%d\t%d\t%d\t\t", proc->pid,
+              parent == NULL ? -1 : parent->pid, proc->cold->base_priority);
+      switch (proc->status) {
+      case READY:        console("READY\t\t"); break;
+      case RUNNING:      console("RUNNING\t\t"); break;
+      case QUIT:         console("QUIT\t\t"); break;
+      case JOIN_BLOCKED: console("JOIN_BLOCKED\t"); break;
+      case ZAP_BLOCKED:  console("ZAP_BLOCKED\t"); break;
+      default:           console("%d\t\t", proc->status); break;
+      }
+      cpu_time = proc->cpu_time;
+      if (proc == Current)
+         cpu_time += sys_clock() - proc->slice_start;
+      console("%d\t%d\t%s\n", kids, cpu_time / 1000, proc->cold->name);
+   }
+   psr_set(old_psr);
+} /* dump_processes */
+
+
 /* ------------------------------------------------------------------------
    Name - dispatcher
    Purpose - dispatches ready processes.  The process with the highest
-             priority (the first on the ready list) is scheduled to
-             run.  The old process is swapped out and the new process
-             swapped in.
+             priority (the head of the highest non-empty ready queue) is
+             scheduled to run.  The old process is swapped out and the new
+             process swapped in.  A running process is only displaced by
+             a strictly higher priority one, and then resumes ahead of its
+             peers.  time_slice() requeues it behind them instead.  A
+             process left in Handoff by wake_one() is switched to without
+             going through the ready queues, unless something queued
+             since outranks it or it no longer outranks Current.
    Parameters - none
    Returns - nothing
    Side Effects - the context of the machine is changed
    ----------------------------------------------------------------------- */
 void dispatcher(void)
 {
-   proc_ptr next_process;
+   proc_ptr next_process = Handoff;
+   proc_ptr old_process = Current;
+   int now;
+
+   Handoff = NULL;
+   if (next_process != NULL &&
+       ((ReadyMask & ((2u << next_process->priority) - 1)) != 0 ||
+        (old_process->status == RUNNING &&
+         next_process->priority >= old_process->priority))) {
+      /* anything of its priority was woken after it */
+      ready_push_head(next_process);
+      next_process = NULL;
+   }
+
+   if (old_process != NULL && old_process->status == RUNNING) {
+      if (next_process == NULL && !ready_outranks(old_process))
+         return;
+      old_process->status = READY;
+      ready_push_head(old_process);
+   }
+
+   /* charge the old process for its slice, and its group before the
+      groups are compared, and start the new one's */
+   now = sys_clock();
+   if (old_process != NULL) {
+#if STRIDE_SCHED
+      if (GROUP_QUEUED(old_process))
+         group_charge(old_process->group, now - old_process->slice_start);
+#endif
+      old_process->cpu_time += now - old_process->slice_start;
+   }
+   if (next_process == NULL)
+      next_process = ready_pop();
+   next_process->status = RUNNING;
+   next_process->slice_start = now;
+   if (next_process == old_process)
+      return;
+   Current = next_process;
 
-   p1_switch(Current->pid, next_process->pid);
+   trace_log(TRACE_CAT_SCHED, TRACE_VERBOSE, "dispatcher(): %d -> %d\n",
+             old_process == NULL ? -1 : old_process->pid, next_process->pid);
+   p1_switch(old_process == NULL ? -1 : old_process->pid, next_process->pid);
+#if LAZY_CONTEXT
+   if (next_process->unbound)
+      context_bind(next_process);
+#endif
+   context_switch(old_process == NULL ? NULL : &old_process->cold->state,
+                  &next_process->cold->state);
 } /* dispatcher */
 
 
 /* ------------------------------------------------------------------------
-   Name - sentinel
-   Purpose - The purpose of the sentinel routine is two-fold.  One
-             responsibility is to keep the system going when all other
-	     processes are blocked.  The other is to detect and report
-	     simple deadlock states.
+   Name - time_slice
+   Purpose - Round-robin among processes of equal priority.  Once Current
+             has run for its priority's quantum it goes to the tail of its
+             ready queue.  Returns at once unless some other process of
+             the same or better priority is ready, or with STRIDE_SCHED
+             one in its group or in any other group.
    Parameters - none
    Returns - nothing
-   Side Effects -  if system is in deadlock, print appropriate error
-		   and halt.
+   Side Effects - may call the dispatcher
    ----------------------------------------------------------------------- */
-int sentinel (void * dummy)
+void time_slice(void)
 {
-   if (DEBUG && debugflag)
-      console("sentinel(): called\n");
-   while (1)
-   {
-      check_deadlock();
-      waitint();
+   unsigned int old_psr = psr_get();
+   unsigned int peers;
+   int waiting;
+
+   check_kernel_mode("time_slice");
+   disableInterrupts();
+
+   /* bits 0 .. Current->priority of ReadyMask */
+   peers = (2u << Current->priority) - 1;
+   waiting = (ReadyMask & peers) != 0;
+#if STRIDE_SCHED
+   /* the same within Current's group, and groups take turns whatever
+      their priorities */
+   if (GROUP_QUEUED(Current))
+      waiting = waiting || (Current->group->ready_mask & peers) != 0 ||
+                (RunGroups != NULL && (RunGroups != Current->group ||
+                                       RunGroups->next_group != NULL));
+   else if (Current->priority == SENTINELPRIORITY)
+      waiting = waiting || RunGroups != NULL;
+#endif
+   if (waiting &&
+       sys_clock() - Current->slice_start >= Quantum[Current->priority]) {
+      trace_log(TRACE_CAT_SCHED, TRACE_VERBOSE,
+                "time_slice(): process %d used its quantum\n", Current->pid);
+      Current->status = READY;
+      ready_push_tail(Current);
+      dispatcher();
    }
-} /* sentinel */
 
+   psr_set(old_psr);
+} /* time_slice */
 
-/* check to determine if deadlock has occurred... */
-static void check_deadlock()
+
+/* the clock interrupt drives time slicing, once startup() has dispatched
+   the first process; fork1() enables interrupts before that */
+static void clock_handler(int dev, void *unit)
 {
-} /* check_deadlock */
+   if (Current == NO_CURRENT_PROCESS)
+      return;
+   if (EdfList != NULL)
+      edf_tick();
+   time_slice();
+} /* clock_handler */
 
 
-/*
- * Disables the interrupts.
- */
-void disableInterrupts()
+/* ------------------------------------------------------------------------
+   Name - edf_admit, edf_retire
+   Purpose - Move a process into and out of the deadline class.  Its
+             first period starts at admission.
+   Parameters - the process; for edf_admit() its period and budget in
+                milliseconds and the share of the processor they take
+   Returns - nothing
+   Side Effects - EdfList and EdfUtil are updated
+   ----------------------------------------------------------------------- */
+static void edf_admit(proc_ptr proc, int period, int budget, int util)
 {
-  /* turn the interrupts OFF iff we are in kernel mode */
-  if((PSR_CURRENT_MODE & psr_get()) == 0) {
-    //not in kernel mode
-    console("Kernel Error: Not in kernel mode, may not disable interrupts\n");
-    halt(1);
-  } else
-    /* We ARE in kernel mode */
-    psr_set( psr_get() & ~PSR_CURRENT_INT );
-} /* disableInterrupts */
+   proc->cold->period = period * 1000;
+   proc->cold->budget = budget * 1000;
+   proc->cold->deadline = sys_clock() + proc->cold->period;
+   proc->cold->period_cpu = proc->cpu_time;
+   proc->cold->edf_util = util;
+   proc->cold->edf_next = EdfList;
+   EdfList = proc;
+   EdfUtil += util;
+   trace_log(TRACE_CAT_FORK, TRACE_INFO, "edf_admit(): process %d, %d of "
+             "every %d ms, %d/1000 reserved\n", proc->pid, budget, period,
+             EdfUtil);
+   set_base_priority(proc, EDF_PRIORITY);
+} /* edf_admit */
+
+
+static void edf_retire(proc_ptr proc)
+{
+   proc_ptr *link = &EdfList;
+
+   while (*link != proc)
+      link = &(*link)->cold->edf_next;
+   *link = proc->cold->edf_next;
+   EdfUtil -= proc->cold->edf_util;
+   proc->cold->period = proc->cold->budget = 0;
+} /* edf_retire */
+
+
+/* ------------------------------------------------------------------------
+   Name - edf_tick
+   Purpose - Budget enforcement for the deadline class, from the clock
+             interrupt.  Starts a new period for every deadline process
+             whose deadline has passed, restoring it to EDF_PRIORITY if
+             it had been throttled, and throttles Current to MINPRIORITY
+             once it has used up its budget for the period.
+   Parameters - none
+   Returns - nothing
+   Side Effects - may call the dispatcher
+   ----------------------------------------------------------------------- */
+static void edf_tick(void)
+{
+   proc_ptr proc;
+   int now = sys_clock();
+   int cpu;
+
+   for (proc = EdfList; proc != NULL; proc = proc->cold->edf_next) {
+      cpu = proc->cpu_time;
+      if (proc == Current)
+         cpu += now - proc->slice_start;
+
+      if (now - proc->cold->deadline >= 0) {
+         while (now - proc->cold->deadline >= 0)
+            proc->cold->deadline += proc->cold->period;
+         proc->cold->period_cpu = cpu;
+         if (proc->cold->base_priority != EDF_PRIORITY)
+            set_base_priority(proc, EDF_PRIORITY);
+         else if (proc->priority == EDF_PRIORITY &&
+                  proc->status == READY && proc != Handoff) {
+            /* its place in the deadline order has changed */
+            ready_remove(proc);
+            ready_push_tail(proc);
+         }
+      }
+      else if (proc == Current && proc->cold->base_priority == EDF_PRIORITY &&
+               cpu - proc->cold->period_cpu >= proc->cold->budget) {
+         trace_log(TRACE_CAT_SCHED, TRACE_VERBOSE, "edf_tick(): process %d "
+                   "used its budget\n", proc->pid);
+         set_base_priority(proc, MINPRIORITY);
+      }
+   }
+
+   if (Current->status == RUNNING)
+      dispatcher();
+} /* edf_tick */
+
+
+/* ------------------------------------------------------------------------
+   Name - set_tickets
+   Purpose - Makes a process the leader of a stride scheduling group with
+             the given number of tickets.  Its live descendants in its
+             current group move to the new group with it, and processes
+             it forks later join it.  The group starts level with the one
+             it leaves.  Calling it again on a leader changes the tickets.
+             Without STRIDE_SCHED the groups are kept but not used.
+   Parameters - pid of the process; tickets, at least 1
+   Returns - 0, or -1 if the process does not exist or has quit or
+             tickets is below 1
+   Side Effects - group pointers in the subtree change
+   ------------------------------------------------------------------------ */
+int set_tickets(int pid, int tickets)
+{
+   proc_ptr proc;
+   sched_group *group;
+
+   check_kernel_mode("set_tickets");
+   disableInterrupts();
+
+   proc = find_proc(pid);
+   if (proc == NULL || proc->status == QUIT || tickets < 1 ||
+       tickets > STRIDE_ONE) {
+      enableInterrupts();
+      return -1;
+   }
+
+   group = &proc->cold->own_group;
+   if (proc->group != group) {
+      group->pass = proc->group->pass;
+      group_clear(group);
+      group_move(proc, proc->group, group);
+   }
+   group->tickets = tickets;
+   group->stride = STRIDE_ONE / tickets;
+   trace_log(TRACE_CAT_SCHED, TRACE_INFO, "set_tickets(): process %d leads "
+             "a group with %d tickets\n", pid, tickets);
+
+   enableInterrupts();
+   return 0;
+} /* set_tickets */
+
+
+/* moves proc and its live descendants that are in group from to group to */
+static void group_move(proc_ptr proc, sched_group *from, sched_group *to)
+{
+   proc_ptr child;
+
+   if (proc->group != from)
+      return;
+#if STRIDE_SCHED
+   if (proc->status == READY) {
+      ready_remove(proc);
+      proc->group = to;
+      ready_push_tail(proc);
+   }
+   else
+#endif
+      proc->group = to;
+   for (child = proc->child_proc_ptr; child != NULL;
+        child = child->next_sibling_ptr)
+      group_move(child, from, to);
+} /* group_move */
+
+
+/* empties a group's ready queues; it must not be on RunGroups */
+static void group_clear(sched_group *group)
+{
+   int i;
+
+   for (i = 0; i < LOWEST_PRIORITY; i++)
+      group->ready[i].head = group->ready[i].tail = NULL;
+   group->ready_mask = 0;
+   group->next_group = NULL;
+} /* group_clear */
+
+
+#if STRIDE_SCHED
+/* ------------------------------------------------------------------------
+   Name - group_push, group_remove, group_pop
+   Purpose - The ready queues of the stride groups.  A group queues its
+             members by priority as ReadyList does, and RunGroups keeps
+             the groups with a ready member in pass order, so the next
+             process is the best one of the first group.  A group that
+             goes from idle to runnable has its pass raised to
+             GlobalPass first.
+   ----------------------------------------------------------------------- */
+static void group_push(proc_ptr proc, int ahead)
+{
+   sched_group *group = proc->group;
+
+   if (group->ready_mask == 0) {
+      if (group->pass < GlobalPass)
+         group->pass = GlobalPass;
+      group_link(group);
+   }
+   if (ahead)
+      queue_push_head(&group->ready[proc->priority], proc);
+   else
+      queue_push(&group->ready[proc->priority], proc);
+   group->ready_mask |= 1u << proc->priority;
+   ReadyCount++;
+} /* group_push */
+
+
+static void group_remove(proc_ptr proc)
+{
+   sched_group *group = proc->group;
+   proc_queue *queue = &group->ready[proc->priority];
+
+   queue_remove(queue, proc);
+   if (queue->head == NULL) {
+      group->ready_mask &= ~(1u << proc->priority);
+      if (group->ready_mask == 0)
+         group_unlink(group);
+   }
+   ReadyCount--;
+} /* group_remove */
+
+
+/* RunGroups must not be empty */
+static proc_ptr group_pop(void)
+{
+   sched_group *group = RunGroups;
+   proc_queue *queue = &group->ready[__builtin_ctz(group->ready_mask)];
+   proc_ptr proc = queue_pop(queue);
+
+   if (queue->head == NULL) {
+      group->ready_mask &= ~(1u << proc->priority);
+      if (group->ready_mask == 0) {
+         RunGroups = group->next_group;
+         group->next_group = NULL;
+      }
+   }
+   if (group->pass > GlobalPass)
+      GlobalPass = group->pass;
+   ReadyCount--;
+   return proc;
+} /* group_pop */
+
+
+/* adds usec of running to a group's pass, keeping RunGroups in order */
+static void group_charge(sched_group *group, int usec)
+{
+   group->pass += (long long) group->stride * usec;
+   if (group->ready_mask != 0) {
+      group_unlink(group);
+      group_link(group);
+   }
+} /* group_charge */
+
+
+/* puts a group on RunGroups behind those with the same or a lower pass */
+static void group_link(sched_group *group)
+{
+   sched_group **link = &RunGroups;
+
+   while (*link != NULL && (*link)->pass <= group->pass)
+      link = &(*link)->next_group;
+   group->next_group = *link;
+   *link = group;
+} /* group_link */
+
+
+static void group_unlink(sched_group *group)
+{
+   sched_group **link = &RunGroups;
+
+   while (*link != group)
+      link = &(*link)->next_group;
+   *link = group->next_group;
+   group->next_group = NULL;
+} /* group_unlink */
+#endif
+
+
+/* ------------------------------------------------------------------------
+   Name - queue_push, queue_pop
+   Purpose - Append to and remove from the head of a proc_queue.
+   ----------------------------------------------------------------------- */
+static void queue_push(proc_queue *queue, proc_ptr proc)
+{
+   proc->next_proc_ptr = NULL;
+   if (queue->tail == NULL)
+      queue->head = proc;
+   else
+      queue->tail->next_proc_ptr = proc;
+   queue->tail = proc;
+} /* queue_push */
+
+
+static void queue_push_head(proc_queue *queue, proc_ptr proc)
+{
+   proc->next_proc_ptr = queue->head;
+   if (queue->tail == NULL)
+      queue->tail = proc;
+   queue->head = proc;
+} /* queue_push_head */
+
+
+/* returns NULL if the queue is empty */
+static proc_ptr queue_pop(proc_queue *queue)
+{
+   proc_ptr proc = queue->head;
+
+   if (proc != NULL) {
+      queue->head = proc->next_proc_ptr;
+      if (queue->head == NULL)
+         queue->tail = NULL;
+      proc->next_proc_ptr = NULL;
+   }
+   return proc;
+} /* queue_pop */
+
+
+/* takes a process off the middle of a queue it is on */
+static void queue_remove(proc_queue *queue, proc_ptr proc)
+{
+   proc_ptr prev = NULL;
+   proc_ptr walk;
+
+   for (walk = queue->head; walk != proc; walk = walk->next_proc_ptr)
+      prev = walk;
+   if (prev == NULL)
+      queue->head = proc->next_proc_ptr;
+   else
+      prev->next_proc_ptr = proc->next_proc_ptr;
+   if (queue->tail == proc)
+      queue->tail = prev;
+   proc->next_proc_ptr = NULL;
+} /* queue_remove */
+
+
+/* ------------------------------------------------------------------------
+   Name - ready_push_tail, ready_push_head, ready_pop
+   Purpose - Constant time operations on the per-priority ready queues.
+             ReadyMask mirrors which queues are non-empty so the highest
+             priority ready process is found with one bit scan.
+   ----------------------------------------------------------------------- */
+static void ready_push_tail(proc_ptr proc)
+{
+#if STRIDE_SCHED
+   if (GROUP_QUEUED(proc)) {
+      group_push(proc, 0);
+      return;
+   }
+#endif
+   if (proc->priority == EDF_PRIORITY)
+      edf_insert(proc, 0);
+   else
+      queue_push(&ReadyList[proc->priority], proc);
+   ReadyMask |= 1u << proc->priority;
+   if (proc->pid != SENTINELPID)
+      ReadyCount++;
+} /* ready_push_tail */
+
+
+static void ready_push_head(proc_ptr proc)
+{
+#if STRIDE_SCHED
+   if (GROUP_QUEUED(proc)) {
+      group_push(proc, 1);
+      return;
+   }
+#endif
+   if (proc->priority == EDF_PRIORITY)
+      edf_insert(proc, 1);
+   else
+      queue_push_head(&ReadyList[proc->priority], proc);
+   ReadyMask |= 1u << proc->priority;
+   if (proc->pid != SENTINELPID)
+      ReadyCount++;
+} /* ready_push_head */
+
+
+/* ------------------------------------------------------------------------
+   Name - edf_insert
+   Purpose - Keeps the EDF_PRIORITY ready queue in deadline order.
+   Parameters - the process; non-zero to go ahead of those with the same
+                deadline rather than behind them
+   Returns - nothing
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+static void edf_insert(proc_ptr proc, int ahead)
+{
+   proc_queue *queue = &ReadyList[EDF_PRIORITY];
+   proc_ptr prev = NULL;
+   proc_ptr walk;
+   int diff;
+
+   for (walk = queue->head; walk != NULL; walk = walk->next_proc_ptr) {
+      diff = walk->cold->deadline - proc->cold->deadline;
+      if (diff > 0 || (diff == 0 && ahead))
+         break;
+      prev = walk;
+   }
+   proc->next_proc_ptr = walk;
+   if (prev == NULL)
+      queue->head = proc;
+   else
+      prev->next_proc_ptr = proc;
+   if (walk == NULL)
+      queue->tail = proc;
+} /* edf_insert */
+
+
+/* non-zero if a ready process should displace proc, which is running */
+static int ready_outranks(proc_ptr proc)
+{
+   proc_ptr head;
+
+#if STRIDE_SCHED
+   /* by priority within proc's group; between groups only the clock
+      preempts, except that deadline processes run at once and anything
+      displaces the sentinel */
+   if (GROUP_QUEUED(proc) && (ReadyMask & (1u << EDF_PRIORITY)) == 0)
+      return proc->group->ready_mask != 0 &&
+             __builtin_ctz(proc->group->ready_mask) < proc->priority;
+   if (proc->priority == SENTINELPRIORITY && RunGroups != NULL)
+      return 1;
+#endif
+   if (ReadyMask == 0)
+      return 0;
+   if (ready_best_priority() != proc->priority)
+      return ready_best_priority() < proc->priority;
+   head = ReadyList[EDF_PRIORITY].head;
+   return proc->priority == EDF_PRIORITY &&
+          head->cold->deadline - proc->cold->deadline < 0;
+} /* ready_outranks */
+
+
+/* priority of the best ready process; ReadyMask must be non-zero */
+static int ready_best_priority(void)
+{
+   return __builtin_ctz(ReadyMask);
+} /* ready_best_priority */
+
+
+static proc_ptr ready_pop(void)
+{
+   proc_queue *queue;
+   proc_ptr proc;
+
+#if STRIDE_SCHED
+   if ((ReadyMask & (1u << EDF_PRIORITY)) == 0 && RunGroups != NULL)
+      return group_pop();
+#endif
+   if (ReadyMask == 0) {
+      console("dispatcher(): no process is ready to run. Halting...\n");
+      halt(1);
+   }
+   queue = &ReadyList[ready_best_priority()];
+   proc = queue_pop(queue);
+   if (queue->head == NULL)
+      ReadyMask &= ~(1u << proc->priority);
+   if (proc->pid != SENTINELPID)
+      ReadyCount--;
+   return proc;
+} /* ready_pop */
+
+
+/* ------------------------------------------------------------------------
+   Name - wait_on, wake_all
+   Purpose - Wait queues let quit() wake exactly the processes blocked on
+             it, in the order they blocked, without scanning ProcTable.
+             wait_on() only queues Current; the caller then dispatches.
+   ----------------------------------------------------------------------- */
+static void wait_on(proc_queue *queue, int status)
+{
+   Current->status = status;
+   BlockedCount++;
+   queue_push(queue, Current);
+} /* wait_on */
+
+
+static void wake_all(proc_queue *queue)
+{
+   proc_ptr proc;
+
+   while ((proc = queue_pop(queue)) != NULL) {
+      trace_log(TRACE_CAT_SCHED, TRACE_VERBOSE, "wake_all(): process %d\n",
+                proc->pid);
+      wake_one(proc);
+   }
+} /* wake_all */
+
+
+/* ------------------------------------------------------------------------
+   Name - wake_one
+   Purpose - Makes a blocked process ready.  If the dispatcher call that
+             follows would pick it anyway -- nothing of its priority or
+             better is ready and Current is not running or is outranked --
+             it is kept in Handoff instead of taking a round trip through
+             its ready queue.  Never with STRIDE_SCHED, where the pick
+             depends on the groups.
+   Parameters - the process, already off any wait queue
+   Returns - nothing
+   Side Effects - the caller must call dispatcher() before anything else
+                  looks at the ready queues
+   ----------------------------------------------------------------------- */
+static void wake_one(proc_ptr proc)
+{
+   proc->status = READY;
+   BlockedCount--;
+   if (!STRIDE_SCHED && Handoff == NULL &&
+       (ReadyMask & ((2u << proc->priority) - 1)) == 0 &&
+       (Current->status != RUNNING || proc->priority < Current->priority))
+      Handoff = proc;
+   else
+      ready_push_tail(proc);
+} /* wake_one */
+
+
+#if PRIO_INHERIT
+/* ------------------------------------------------------------------------
+   Name - inherit_priority
+   Purpose - Sets a process's priority to the best of its own and those
+             of the processes waiting on it: its zappers, and its parent
+             if that is blocked in join().  A change is passed on to
+             whatever the process is itself waiting on.  Called when a
+             wait on the process begins, and when its parent stops
+             waiting in join(); a zap wait ends only when its target quits.
+   Parameters - the process
+   Returns - nothing
+   Side Effects - the process may move to another ready queue
+   ----------------------------------------------------------------------- */
+static void inherit_priority(proc_ptr proc)
+{
+   proc_ptr waiter;
+   int priority = proc->cold->base_priority;
+
+   if (proc->status == QUIT)
+      return;
+   for (waiter = proc->zappers.head; waiter != NULL;
+        waiter = waiter->next_proc_ptr)
+      if (waiter->priority < priority)
+         priority = waiter->priority;
+   waiter = proc->cold->parent_ptr;
+   if (waiter != NULL && waiter->status == JOIN_BLOCKED &&
+       waiter->priority < priority)
+      priority = waiter->priority;
+   /* only a process with a deadline can be ordered by one */
+   if (priority == EDF_PRIORITY && proc->cold->period == 0)
+      priority = MAXPRIORITY;
+   if (priority == proc->priority)
+      return;
+
+   trace_log(TRACE_CAT_SCHED, TRACE_VERBOSE,
+             "inherit_priority(): process %d priority %d -> %d\n",
+             proc->pid, proc->priority, priority);
+   change_priority(proc, priority);
+
+   /* the wait-for graph has no cycles; zap() and join() halt first */
+   if (proc->status == ZAP_BLOCKED)
+      inherit_priority(proc->zap_target);
+   else if (proc->status == JOIN_BLOCKED)
+      inherit_children(proc);
+} /* inherit_priority */
+
+
+/* ------------------------------------------------------------------------
+   Name - inherit_children
+   Purpose - Calls inherit_priority() on each child of a process, oldest
+             first.  With ready_push_ranked() this keeps children boosted
+             onto one ready queue in base priority order, and siblings of
+             the same base priority in the order they were forked.
+   Parameters - the parent
+   Returns - nothing
+   Side Effects - children may move to other ready queues
+   ----------------------------------------------------------------------- */
+static void inherit_children(proc_ptr parent)
+{
+   proc_ptr child = parent->child_proc_ptr;
+
+   if (child == NULL)
+      return;
+   while (child->next_sibling_ptr != NULL)
+      child = child->next_sibling_ptr;
+   for (; child != NULL; child = child->cold->prev_sibling_ptr)
+      inherit_priority(child);
+} /* inherit_children */
+
+
+/* ------------------------------------------------------------------------
+   Name - ready_push_ranked
+   Purpose - Puts a process whose priority changed on its new ready queue
+             behind those of the same or better base priority and ahead
+             of the rest, so processes boosted onto one queue run in the
+             order of their own priorities.  Without inheritance every
+             process on a queue has that base priority, and this is
+             ready_push_tail().
+   Parameters - the process, with its new priority set
+   Returns - nothing
+   Side Effects - ReadyCount is changed
+   ----------------------------------------------------------------------- */
+static void ready_push_ranked(proc_ptr proc)
+{
+   proc_queue *queue = &ReadyList[proc->priority];
+   proc_ptr prev = NULL;
+   proc_ptr walk;
+
+#if STRIDE_SCHED
+   if (GROUP_QUEUED(proc))
+      queue = &proc->group->ready[proc->priority];
+#endif
+   if (proc->priority == EDF_PRIORITY || queue->tail == NULL ||
+       queue->tail->cold->base_priority <= proc->cold->base_priority) {
+      ready_push_tail(proc);
+      return;
+   }
+   for (walk = queue->head;
+        walk->cold->base_priority <= proc->cold->base_priority;
+        walk = walk->next_proc_ptr)
+      prev = walk;
+   if (prev == NULL) {
+      ready_push_head(proc);
+      return;
+   }
+   /* the queue is non-empty, so its mask bit and group link are set */
+   proc->next_proc_ptr = walk;
+   prev->next_proc_ptr = proc;
+   ReadyCount++;
+} /* ready_push_ranked */
+#endif
+
+
+/* ------------------------------------------------------------------------
+   Name - set_base_priority, change_priority
+   Purpose - set_base_priority() gives a process a new priority of its
+             own; with PRIO_INHERIT it may still run at a better one
+             inherited from its waiters.  change_priority() sets the
+             priority it runs at, moving it to its new ready queue if it
+             is on one: to the tail, or with PRIO_INHERIT by base
+             priority (see ready_push_ranked()).
+   ----------------------------------------------------------------------- */
+static void set_base_priority(proc_ptr proc, int priority)
+{
+   proc->cold->base_priority = priority;
+#if PRIO_INHERIT
+   inherit_priority(proc);
+#else
+   if (priority != proc->priority)
+      change_priority(proc, priority);
+#endif
+} /* set_base_priority */
+
+
+static void change_priority(proc_ptr proc, int priority)
+{
+   if (proc->status == READY && proc != Handoff) {
+      ready_remove(proc);
+      proc->priority = priority;
+#if PRIO_INHERIT
+      ready_push_ranked(proc);
+#else
+      ready_push_tail(proc);
+#endif
+   }
+   else
+      proc->priority = priority;
+} /* change_priority */
+
+
+/* takes a process off the middle of its ready queue */
+static void ready_remove(proc_ptr proc)
+{
+   proc_queue *queue = &ReadyList[proc->priority];
+
+#if STRIDE_SCHED
+   if (GROUP_QUEUED(proc)) {
+      group_remove(proc);
+      return;
+   }
+#endif
+   queue_remove(queue, proc);
+   if (queue->head == NULL)
+      ReadyMask &= ~(1u << proc->priority);
+   if (proc->pid != SENTINELPID)
+      ReadyCount--;
+} /* ready_remove */
+
+
+/* ------------------------------------------------------------------------
+   Name - find_proc
+   Purpose - Maps a pid to its process table entry through PidHash.
+   Parameters - the pid
+   Returns - the entry, or NULL if no live or unjoined process has that pid
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+static proc_ptr find_proc(int pid)
+{
+   proc_ptr proc;
+
+   if (pid < SENTINELPID)
+      return NULL;
+   for (proc = PidHash[pid % PID_HASH_SIZE]; proc != NULL;
+        proc = proc->next_hash_ptr)
+      if (proc->pid == pid)
+         return proc;
+   return NULL;
+} /* find_proc */
+
+
+/* ------------------------------------------------------------------------
+   Name - alloc_slot
+   Purpose - Pops an EMPTY slot off the free-slot stack, growing the table
+             by a chunk when the stack is empty, and gives it the next
+             pid.  Pids count up from next_pid and wrap back to
+             SENTINELPID before they overflow, skipping any still in use.
+   Parameters - none
+   Returns - the slot, with its pid filled in and hashed, or NULL if the
+             table is full
+   Side Effects - may grow the table
+   ----------------------------------------------------------------------- */
+static proc_ptr alloc_slot(void)
+{
+   proc_ptr proc;
+
+   if (FreeSlots == NULL && (ProcSlots == PROC_LIMIT || !grow_table()))
+      return NULL;
+   proc = FreeSlots;
+   FreeSlots = proc->next_proc_ptr;
+   proc->next_proc_ptr = NULL;
+
+   do {
+      proc->pid = next_pid;
+      next_pid = next_pid == PID_MAX ? SENTINELPID : next_pid + 1;
+   } while (find_proc(proc->pid) != NULL);
+   proc->next_hash_ptr = PidHash[proc->pid % PID_HASH_SIZE];
+   PidHash[proc->pid % PID_HASH_SIZE] = proc;
+   return proc;
+} /* alloc_slot */
+
+
+/* adds the next chunk of EMPTY slots, hot and cold halves, to the table
+   and pushes them on the free-slot stack, lowest on top; 0 if out of
+   memory */
+static int grow_table(void)
+{
+   int i;
+   int count = PROC_LIMIT - ProcSlots < PROC_CHUNK ?
+               PROC_LIMIT - ProcSlots : PROC_CHUNK;
+   void *hot;
+   proc_ptr chunk;
+   proc_cold *cold;
+
+   if (posix_memalign(&hot, CACHE_LINE, count * sizeof(proc_struct)) != 0)
+      return 0;
+   cold = calloc(count, sizeof(proc_cold));
+   if (cold == NULL) {
+      free(hot);
+      return 0;
+   }
+   memset(hot, 0, count * sizeof(proc_struct));
+   chunk = hot;
+   for (i = count - 1; i >= 0; i--) {
+      chunk[i].cold = &cold[i];
+      chunk[i].next_proc_ptr = FreeSlots;
+      FreeSlots = &chunk[i];
+   }
+   ProcTable[ProcSlots / PROC_CHUNK] = chunk;
+   ProcCold[ProcSlots / PROC_CHUNK] = cold;
+   ProcSlots += count;
+   return 1;
+} /* grow_table */
+
+
+/* ------------------------------------------------------------------------
+   Name - release_slot
+   Purpose - Returns a reaped process's slot, stack and strings to the
+             free pool.
+   Parameters - the process, which must not be running or on a queue
+   Returns - nothing
+   Side Effects - the pid no longer resolves through find_proc()
+   ----------------------------------------------------------------------- */
+static void release_slot(proc_ptr proc)
+{
+   proc_ptr *link;
+
+   for (link = &PidHash[proc->pid % PID_HASH_SIZE]; *link != proc;
+        link = &(*link)->next_hash_ptr)
+      ;
+   *link = proc->next_hash_ptr;
+   proc->next_hash_ptr = NULL;
+
+   if (proc->cold->stack != NULL)
+      stack_free(proc->cold->stack, proc->cold->stacksize,
+                 proc->cold->stack_class);
+   proc->cold->stack = NULL;
+   str_free(proc->cold->name, proc->cold->name_class);
+   str_free(proc->cold->start_arg, proc->cold->arg_class);
+   proc->cold->name = NULL;
+   proc->cold->start_arg = NULL;
+   proc->status = EMPTY;
+   proc->next_proc_ptr = FreeSlots;
+   FreeSlots = proc;
+} /* release_slot */
+
+
+/* ------------------------------------------------------------------------
+   Name - context_bind
+   Purpose - Gives a new process its stack and a context that starts in
+             launch().  fork1() does this at once, or with LAZY_CONTEXT
+             the dispatcher does when it first switches to the process.
+   Parameters - the process; its stacksize is the size requested
+   Returns - nothing
+   Side Effects - the stack is allocated
+   ----------------------------------------------------------------------- */
+static void context_bind(proc_ptr proc)
+{
+   proc_cold *cold = proc->cold;
+
+   cold->stack = stack_alloc(cold->stacksize, &cold->stack_class);
+   if (cold->stack_class != NO_STACK_CLASS)
+      cold->stacksize = STACK_CLASS_SIZE(cold->stack_class);
+
+   /* Initialize context for this process, but use launch function pointer for
+    * the initial value of the process's program counter (PC)
+    */
+   context_init(&(cold->state), psr_get(), cold->stack, cold->stacksize,
+                launch);
+   proc->unbound = 0;
+} /* context_bind */
+
+
+/* ------------------------------------------------------------------------
+   Name - stack_arena_init
+   Purpose - Carves the stacks of every size class out of one allocation
+             and threads them onto the per-class free lists, so fork1()
+             and join() never call the general-purpose allocator for
+             stacks that fit a class.  With STACK_GUARD the arena is
+             mmap'd and each stack gets its guard page here, once.
+   Parameters - none
+   Returns - nothing
+   Side Effects - halts if the arena cannot be allocated
+   ----------------------------------------------------------------------- */
+static void stack_arena_init(void)
+{
+   int c, i;
+   size_t guard = 0;
+   size_t arena_size = 0;
+   char *block;
+
+#if STACK_GUARD
+   stack_guard_init();
+   guard = GuardSize;
+#endif
+   for (c = 0; c < STACK_CLASSES; c++)
+      arena_size += STACK_CLASS_COUNT(c) * (guard + STACK_CLASS_SIZE(c));
+#if STACK_GUARD
+   block = mmap(NULL, arena_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANON, -1, 0);
+   if (block == MAP_FAILED)
+      block = NULL;
+#else
+   block = malloc(arena_size);
+#endif
+   if (block == NULL) {
+      console("startup(): cannot allocate stack arena.  Halting...\n");
+      halt(1);
+   }
+
+   for (c = 0; c < STACK_CLASSES; c++) {
+      StackFree[c] = NULL;
+      for (i = 0; i < STACK_CLASS_COUNT(c); i++) {
+#if STACK_GUARD
+         if (mprotect(block, guard, PROT_NONE) != 0) {
+            console("startup(): cannot protect stack guard page.  "
+                    "Halting...\n");
+            halt(1);
+         }
+#endif
+         block += guard;
+         *(char **) block = StackFree[c];
+         StackFree[c] = block;
+         block += STACK_CLASS_SIZE(c);
+      }
+   }
+} /* stack_arena_init */
+
+
+/* ------------------------------------------------------------------------
+   Name - stack_alloc
+   Purpose - Takes a stack from the smallest size class that fits and
+             still has a free stack, falling back to malloc().
+   Parameters - requested size; where to record the class used
+   Returns - the stack
+   Side Effects - halts if the fallback allocation fails
+   ----------------------------------------------------------------------- */
+static char *stack_alloc(int stacksize, int *stack_class)
+{
+   int c;
+   char *stack;
+
+   for (c = 0; c < STACK_CLASSES; c++)
+      if (stacksize <= STACK_CLASS_SIZE(c) && StackFree[c] != NULL) {
+         stack = StackFree[c];
+         StackFree[c] = *(char **) stack;
+         *stack_class = c;
+         return stack;
+      }
+
+#if STACK_GUARD
+   stack = mmap(NULL, GuardSize + stacksize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANON, -1, 0);
+   if (stack == MAP_FAILED || mprotect(stack, GuardSize, PROT_NONE) != 0)
+      stack = NULL;
+   else
+      stack += GuardSize;
+#else
+   stack = malloc(stacksize);
+#endif
+   if (stack == NULL) {
+      console("fork1(): out of memory for process stack.  Halting...\n");
+      halt(1);
+   }
+   *stack_class = NO_STACK_CLASS;
+   return stack;
+} /* stack_alloc */
+
+
+/* returns a stack to its size class, or to the system if it came from there */
+static void stack_free(char *stack, int stacksize, int stack_class)
+{
+   if (stack_class == NO_STACK_CLASS) {
+#if STACK_GUARD
+      munmap(stack - GuardSize, GuardSize + stacksize);
+#else
+      free(stack);
+#endif
+      return;
+   }
+   *(char **) stack = StackFree[stack_class];
+   StackFree[stack_class] = stack;
+} /* stack_free */
+
+
+/* ------------------------------------------------------------------------
+   Name - str_copy
+   Purpose - Copies a string into the smallest string arena class that
+             holds it, carving a new slab for the class if it has no free
+             string, or into malloc'd memory if no class is big enough.
+   Parameters - the string; where to record the class used
+   Returns - the copy
+   Side Effects - halts if memory runs out
+   ----------------------------------------------------------------------- */
+static char *str_copy(const char *str, int *str_class)
+{
+   int c, i;
+   size_t len = strlen(str) + 1;
+   char *copy;
+
+   for (c = 0; c < STR_CLASSES && len > STR_CLASS_SIZE(c); c++)
+      ;
+   if (c == STR_CLASSES) {
+      copy = malloc(len);
+      c = NO_STR_CLASS;
+   }
+   else {
+      if (StrFree[c] == NULL && (copy = malloc(STR_SLAB)) != NULL)
+         for (i = 0; i < STR_SLAB / STR_CLASS_SIZE(c); i++) {
+            *(char **) copy = StrFree[c];
+            StrFree[c] = copy;
+            copy += STR_CLASS_SIZE(c);
+         }
+      copy = StrFree[c];
+      if (copy != NULL)
+         StrFree[c] = *(char **) copy;
+   }
+   if (copy == NULL) {
+      console("fork1(): out of memory for process strings.  Halting...\n");
+      halt(1);
+   }
+   memcpy(copy, str, len);
+   *str_class = c;
+   return copy;
+} /* str_copy */
+
+
+/* returns a string to its arena class or the system; borrowed ones are
+   left alone */
+static void str_free(char *str, int str_class)
+{
+   if (str_class == STR_BORROWED)
+      return;
+   if (str_class == NO_STR_CLASS) {
+      free(str);
+      return;
+   }
+   *(char **) str = StrFree[str_class];
+   StrFree[str_class] = str;
+} /* str_free */
+
+
+#if STACK_GUARD
+/* ------------------------------------------------------------------------
+   Name - stack_guard_init
+   Purpose - Installs the SIGSEGV handler that turns a guard page hit into
+             a clean halt.  The handler runs on its own signal stack.
+   Parameters - none
+   Returns - nothing
+   Side Effects - sets GuardSize to the host page size
+   ----------------------------------------------------------------------- */
+static void stack_guard_init(void)
+{
+   stack_t altstack;
+   struct sigaction action;
+
+   GuardSize = sysconf(_SC_PAGESIZE);
+
+   altstack.ss_sp = GuardSignalStack;
+   altstack.ss_size = sizeof(GuardSignalStack);
+   altstack.ss_flags = 0;
+   sigaltstack(&altstack, NULL);
+
+   action.sa_sigaction = stack_overflow_handler;
+   sigemptyset(&action.sa_mask);
+   action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+   sigaction(SIGSEGV, &action, NULL);
+} /* stack_guard_init */
+
+
+/* only the running process touches its stack, so a guard hit is Current's */
+static void stack_overflow_handler(int sig, siginfo_t *info, void *uc)
+{
+   char *addr = info->si_addr;
+
+   if (Current != NULL && Current->cold->stack != NULL &&
+       addr >= Current->cold->stack - GuardSize &&
+       addr < Current->cold->stack) {
+      console("process %d overflowed its stack.  Halting...\n",
+              Current->pid);
+      halt(1);
+   }
+
+   /* not a guard page hit; let the fault take its default course */
+   signal(SIGSEGV, SIG_DFL);
+} /* stack_overflow_handler */
+#endif
+
+
+/* ------------------------------------------------------------------------
+   Name - sentinel
+   Purpose - The purpose of the sentinel routine is two-fold.  One
+             responsibility is to keep the system going when all other
+	     processes are blocked.  The other is to detect and report
+	     simple deadlock states.
+   Parameters - none
+   Returns - nothing
+   Side Effects -  if system is in deadlock, print appropriate error
+		   and halt.
+   ----------------------------------------------------------------------- */
+int sentinel (char * dummy)
+{
+   trace_log(TRACE_CAT_BOOT, TRACE_INFO, "sentinel(): called\n");
+   while (1)
+   {
+      check_deadlock();
+      waitint();
+   }
+} /* sentinel */
+
+
+/* ------------------------------------------------------------------------
+   Name - check_deadlock
+   Purpose - Halts once every process but the sentinel has quit, or when
+             the remaining ones can never run again.  Uses only the
+             incrementally maintained counts, so the sentinel's check on
+             every wake-up costs O(1).
+   Parameters - none
+   Returns - nothing if some process can still make progress
+   Side Effects - halts the system
+   ----------------------------------------------------------------------- */
+static void check_deadlock()
+{
+   if (LiveCount == 0) {
+      console("All processes completed.\n");
+      halt(0);
+   }
+   if (ReadyCount > 0 || BlockedCount < LiveCount)
+      return;
+
+   trace_log(TRACE_CAT_DEADLOCK, TRACE_INFO, "check_deadlock(): %d live, "
+             "%d ready, %d blocked\n", LiveCount, ReadyCount, BlockedCount);
+   console("check_deadlock(): numProc = %d. Only Sentinel should be left. "
+           "Halting...\n", LiveCount + 1);
+   report_blocked();
+   halt(1);
+} /* check_deadlock */
+
+
+/* ------------------------------------------------------------------------
+   Name - wait_can_finish
+   Purpose - Searches the wait-for graph for a way proc could still quit
+             if Current were to block.  A process in zap() waits on its
+             target and one in join() on any of its live children, so
+             proc can finish iff some process reachable along those edges
+             without passing through Current is ready, running or in
+             block_me().  Callers bump WalkEpoch first; the search is
+             iterative and visits each process at most once.
+   Parameters - the process Current is about to wait on
+   Returns - non-zero if proc might still quit, 0 if it is deadlocked
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+static int wait_can_finish(proc_ptr proc)
+{
+   proc_ptr walk = NULL;
+   proc_ptr child;
+
+   walk_push(&walk, proc);
+   while (walk != NULL) {
+      proc = walk;
+      walk = proc->next_walk_ptr;
+
+      switch (proc->status) {
+      case ZAP_BLOCKED:
+         walk_push(&walk, proc->zap_target);
+         break;
+      case JOIN_BLOCKED:
+         for (child = proc->child_proc_ptr; child != NULL;
+              child = child->next_sibling_ptr)
+            walk_push(&walk, child);
+         break;
+      default:
+         return 1;
+      }
+   }
+   return 0;
+} /* wait_can_finish */
+
+
+/* marks on push, so no process is ever on the search stack twice */
+static void walk_push(proc_ptr *walk, proc_ptr proc)
+{
+   if (proc == Current || proc->walk_mark == WalkEpoch)
+      return;
+   proc->walk_mark = WalkEpoch;
+   proc->next_walk_ptr = *walk;
+   *walk = proc;
+} /* walk_push */
+
+
+/* lists every blocked process and what it is blocked on */
+static void report_blocked(void)
+{
+   int i;
+   proc_ptr proc;
+
+   for (i = 0; i < ProcSlots; i++) {
+      proc = PROC_SLOT(i);
+      switch (proc->status) {
+      case JOIN_BLOCKED:
+         console("   process %d (%s) blocked in join\n",
+                 proc->pid, proc->cold->name);
+         break;
+      case ZAP_BLOCKED:
+         console("   process %d (%s) blocked in zap(%d)\n",
+                 proc->pid, proc->cold->name, proc->zap_target->pid);
+         break;
+      default:
+         if (proc->status > MAX_KERNEL_STATUS)
+            console("   process %d (%s) blocked in block_me(%d)\n",
+                    proc->pid, proc->cold->name, proc->status);
+         break;
+      }
+   }
+} /* report_blocked */
+
+
+/* halts if the caller is running in user mode */
+static void check_kernel_mode(char *caller)
+{
+   if ((PSR_CURRENT_MODE & psr_get()) == 0) {
+      console("%s(): called while in user mode, by process %d. Halting...\n",
+              caller, Current == NULL ? -1 : Current->pid);
+      halt(1);
+   }
+} /* check_kernel_mode */
+
+
+/*
+ * Disables the interrupts.
+ */
+void disableInterrupts()
+{
+  /* turn the interrupts OFF iff we are in kernel mode */
+  if((PSR_CURRENT_MODE & psr_get()) == 0) {
+    //not in kernel mode
+    console("Kernel Error: Not in kernel mode, may not disable interrupts\n");
+    halt(1);
+  } else
+    /* We ARE in kernel mode */
+    psr_set( psr_get() & ~PSR_CURRENT_INT );
+} /* disableInterrupts */
+
+
+/*
+ * Enables the interrupts.
+ */
+static void enableInterrupts()
+{
+  /* turn the interrupts ON iff we are in kernel mode */
+  if((PSR_CURRENT_MODE & psr_get()) == 0) {
+    //not in kernel mode
+    console("Kernel Error: Not in kernel mode, may not enable interrupts\n");
+    halt(1);
+  } else
+    /* We ARE in kernel mode */
+    psr_set( psr_get() | PSR_CURRENT_INT );
+} /* enableInterrupts */
@@ -0,0 +1,31 @@
+/* ------------------------------------------------------------------------
+   phase1ext.h
+
+   Kernel calls this phase 1 provides beyond those the USLOSS phase1.h
+   declares.  Include it after <phase1.h>; it is the same for both
+   backends.
+
+   ------------------------------------------------------------------------ */
+#ifndef _PHASE1EXT_H
+#define _PHASE1EXT_H
+
+/* one process to create with fork_many(); the fields are the arguments
+   of fork1_ptr() */
+typedef struct fork_spec {
+   char  *name;
+   int  (*func)(void *);
+   void  *arg;
+   int    stacksize;
+   int    priority;
+} fork_spec;
+
+extern int   fork1_ptr(char *name, int (*func)(void *), void *arg,
+                       int stacksize, int priority);
+extern int   fork1_deadline(char *name, int (*func)(char *), char *arg,
+                            int stacksize, int period, int budget);
+extern int   fork_many(fork_spec *specs, int count, int *pids);
+extern int   join_all(int *pids, int *statuses, int max);
+extern int   try_join(int *status);
+extern int   set_tickets(int pid, int tickets);
+
+#endif /* _PHASE1EXT_H */
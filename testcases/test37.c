@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "phase1ext.h"
+
+/* The purpose of this test is to demonstrate that
+ * fork1_ptr() hands its argument to the child as is:
+ * the child sees the caller's own structure, not a copy,
+ * and a NULL argument arrives as NULL.  Bad arguments
+ * are rejected as they are by fork1().
+ */
+
+struct counter {
+  char *label;
+  int   count;
+};
+
+int XXp1(void *), XXp2(void *);
+
+int start1(char *arg)
+{
+  struct counter c = { "counter", 0 };
+  int status, pid1, pid2, kidpid;
+
+  printf("start1(): started\n");
+  pid1 = fork1_ptr("XXp1", XXp1, &c, USLOSS_MIN_STACK, 3);
+  printf("start1(): after fork of child %d\n", pid1);
+  pid2 = fork1_ptr("XXp2", XXp2, NULL, USLOSS_MIN_STACK, 3);
+  printf("start1(): after fork of child %d\n", pid2);
+
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  printf("start1(): %s is now %d\n", c.label, c.count);
+
+  printf("start1(): fork1_ptr with no name returned %d\n",
+         fork1_ptr(NULL, XXp2, NULL, USLOSS_MIN_STACK, 3));
+  printf("start1(): fork1_ptr with no function returned %d\n",
+         fork1_ptr("XXp2", NULL, NULL, USLOSS_MIN_STACK, 3));
+  printf("start1(): fork1_ptr with a small stack returned %d\n",
+         fork1_ptr("XXp2", XXp2, NULL, USLOSS_MIN_STACK - 1, 3));
+  printf("start1(): fork1_ptr at priority 0 returned %d\n",
+         fork1_ptr("XXp2", XXp2, NULL, USLOSS_MIN_STACK, 0));
+  return 0;
+} /* start1 */
+
+int XXp1(void *arg)
+{
+  struct counter *c = arg;
+
+  printf("XXp1(): started\n");
+  printf("XXp1(): arg is %s, count %d\n", c->label, c->count);
+  c->count += 5;
+  quit(-1);
+  return 0;
+} /* XXp1 */
+
+int XXp2(void *arg)
+{
+  printf("XXp2(): started\n");
+  printf("XXp2(): arg is %s\n", arg == NULL ? "NULL" : "not NULL");
+  quit(-2);
+  return 0;
+} /* XXp2 */
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "phase1ext.h"
+
+/* The purpose of this test is to demonstrate that
+ * fork_many() creates its whole batch before any of the
+ * children runs, even those that outrank the caller, and
+ * that a bad spec fails on its own without stopping the
+ * rest of the batch.  The children then run in priority
+ * order, and in spec order within a priority.
+ */
+
+int XXp1(char *), Child(void *);
+
+char *names[] = { "C0", "C1", "C2", "C3", "C4" };
+int   prios[] = { 3, 2, 9, 2, 5 };
+
+int start1(char *arg)
+{
+  int status, pid1, kidpid;
+
+  printf("start1(): started\n");
+  pid1 = fork1("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 4);
+  printf("start1(): after fork of child %d\n", pid1);
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  printf("start1(): fork_many with no specs returned %d\n",
+         fork_many(NULL, 1, NULL));
+  return 0;
+} /* start1 */
+
+int XXp1(char *arg)
+{
+  fork_spec specs[5];
+  int pids[5];
+  int i, created, status, kidpid;
+
+  printf("XXp1(): started\n");
+  for (i = 0; i < 5; i++) {
+    specs[i].name = names[i];
+    specs[i].func = Child;
+    specs[i].arg = names[i];
+    specs[i].stacksize = USLOSS_MIN_STACK;
+    specs[i].priority = prios[i];
+  }
+  created = fork_many(specs, 5, pids);
+  printf("XXp1(): fork_many created %d\n", created);
+  for (i = 0; i < 5; i++)
+    printf("XXp1(): spec %d gave %d\n", i, pids[i]);
+  for (i = 0; i < created; i++) {
+    kidpid = join(&status);
+    printf("XXp1(): exit status for child %d is %d\n", kidpid, status);
+  }
+  printf("XXp1(): fork_many of nothing returned %d\n",
+         fork_many(specs, 0, NULL));
+  quit(-1);
+  return 0;
+} /* XXp1 */
+
+int Child(void *arg)
+{
+  printf("%s(): started\n", (char *) arg);
+  quit(getpid());
+  return 0;
+} /* Child */
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "phase1ext.h"
+
+/* The purpose of this test is to demonstrate that
+ * join_all() reaps the children that have quit in the
+ * order they quit, at most max of them, and waits only
+ * when none has quit, and that try_join() never waits:
+ * it returns 0 while children are still running and -2
+ * once there are none.
+ */
+
+int XXp1(char *), Child(char *);
+
+int start1(char *arg)
+{
+  int status, pid1, kidpid;
+
+  printf("start1(): started\n");
+  pid1 = fork1("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 4);
+  printf("start1(): after fork of child %d\n", pid1);
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  return 0;
+} /* start1 */
+
+int XXp1(char *arg)
+{
+  int pids[4], codes[4];
+  int i, count, status, kidpid;
+
+  printf("XXp1(): started\n");
+  printf("XXp1(): try_join with no children returned %d\n",
+         try_join(&status));
+  printf("XXp1(): join_all with no children returned %d\n",
+         join_all(pids, codes, 4));
+
+  fork1("C1", Child, "C1", USLOSS_MIN_STACK, 2);
+  fork1("C2", Child, "C2", USLOSS_MIN_STACK, 2);
+  fork1("C3", Child, "C3", USLOSS_MIN_STACK, 2);
+  printf("XXp1(): join_all with max 0 returned %d\n",
+         join_all(pids, codes, 0));
+  count = join_all(pids, codes, 2);
+  printf("XXp1(): join_all with max 2 returned %d\n", count);
+  for (i = 0; i < count; i++)
+    printf("XXp1(): exit status for child %d is %d\n", pids[i], codes[i]);
+  kidpid = try_join(&status);
+  printf("XXp1(): try_join returned %d, status %d\n", kidpid, status);
+
+  fork1("C4", Child, "C4", USLOSS_MIN_STACK, 5);
+  printf("XXp1(): try_join with C4 running returned %d\n",
+         try_join(&status));
+  count = join_all(pids, codes, 4);
+  printf("XXp1(): join_all returned %d\n", count);
+  for (i = 0; i < count; i++)
+    printf("XXp1(): exit status for child %d is %d\n", pids[i], codes[i]);
+  printf("XXp1(): try_join with no children left returned %d\n",
+         try_join(&status));
+  quit(-1);
+  return 0;
+} /* XXp1 */
+
+int Child(char *arg)
+{
+  printf("%s(): started\n", arg);
+  quit(-getpid());
+  return 0;
+} /* Child */
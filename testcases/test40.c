@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+/* The purpose of this test is to demonstrate that
+ * a process waited on in zap() runs at its waiter's
+ * priority with PRIO_INHERIT=1: start1 zaps XXp1 at
+ * priority 5 while XXp2 at priority 4 is ready, and
+ * XXp1 finishes at start1's priority before XXp2 runs.
+ * Without PRIO_INHERIT, XXp2 runs first; the expected
+ * output with it is in testcases/expected/inherit.
+ */
+
+int XXp1(char *), XXp2(char *);
+
+int start1(char *arg)
+{
+  int status, pid1, pid2, kidpid, result;
+
+  printf("start1(): started\n");
+  pid1 = fork1("XXp1", XXp1, "XXp1", USLOSS_MIN_STACK, 5);
+  printf("start1(): after fork of child %d\n", pid1);
+  pid2 = fork1("XXp2", XXp2, "XXp2", USLOSS_MIN_STACK, 4);
+  printf("start1(): after fork of child %d\n", pid2);
+  printf("start1(): calling zap(%d)\n", pid1);
+  result = zap(pid1);
+  printf("start1(): zap(%d) returned: %d\n", pid1, result);
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  return 0;
+} /* start1 */
+
+int XXp1(char *arg)
+{
+  printf("XXp1(): started\n");
+  dump_processes();
+  printf("XXp1(): is_zapped() returned %d\n", is_zapped());
+  quit(-1);
+  return 0;
+} /* XXp1 */
+
+int XXp2(char *arg)
+{
+  printf("XXp2(): started\n");
+  quit(-2);
+  return 0;
+} /* XXp2 */
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "phase1ext.h"
+
+/* The purpose of this test is to demonstrate that
+ * fork1_deadline() rejects a bad budget or name with -1,
+ * and with -3 a process that would overcommit the
+ * processor.  A deadline process that uses up its budget
+ * drops to MINPRIORITY for the rest of its period, so
+ * start1 runs; it is back at priority 0 once its next
+ * period begins.  The reservation is freed when it quits.
+ */
+
+int Spin(char *), XXp2(char *);
+
+int start1(char *arg)
+{
+  int status, pid1, kidpid;
+
+  printf("start1(): started\n");
+  printf("start1(): budget above period returned %d\n",
+         fork1_deadline("D0", Spin, "D0", USLOSS_MIN_STACK, 100, 200));
+  printf("start1(): budget of 0 returned %d\n",
+         fork1_deadline("D0", Spin, "D0", USLOSS_MIN_STACK, 100, 0));
+  printf("start1(): no name returned %d\n",
+         fork1_deadline(NULL, Spin, "D0", USLOSS_MIN_STACK, 100, 50));
+
+  pid1 = fork1_deadline("D1", Spin, "D1", USLOSS_MIN_STACK, 200, 100);
+  printf("start1(): after fork of deadline child %d\n", pid1);
+  printf("start1(): a second half-processor child returned %d\n",
+         fork1_deadline("D2", XXp2, "D2", USLOSS_MIN_STACK, 100, 50));
+  dump_processes();
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+
+  kidpid = fork1_deadline("D2", XXp2, "D2", USLOSS_MIN_STACK, 100, 50);
+  printf("start1(): after fork of deadline child %d\n", kidpid);
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  return 0;
+} /* start1 */
+
+/* runs into its second period, 250 ms of CPU, before it quits */
+int Spin(char *arg)
+{
+  printf("%s(): started\n", arg);
+  while (readtime() < 250)
+    ;
+  printf("%s(): in its second period\n", arg);
+  dump_processes();
+  quit(-1);
+  return 0;
+} /* Spin */
+
+int XXp2(char *arg)
+{
+  printf("%s(): started\n", arg);
+  quit(-2);
+  return 0;
+} /* XXp2 */
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "phase1ext.h"
+
+/* The purpose of this test is to demonstrate that
+ * set_tickets() rejects a bad pid or ticket count with
+ * -1, and that with STRIDE_SCHED=1 groups share the
+ * processor by tickets rather than priority: XXp1 at
+ * priority 4 with 300 tickets finishes 300 ms of CPU
+ * before XXp2 at priority 2 with 100 tickets, where
+ * without it XXp2 finishes first.  The expected output
+ * with it is in testcases/expected/stride.
+ */
+
+int Spin(char *);
+
+int start1(char *arg)
+{
+  int status, pid1, pid2, kidpid;
+
+  printf("start1(): started\n");
+  pid1 = fork1("XXp1", Spin, "XXp1", USLOSS_MIN_STACK, 4);
+  printf("start1(): after fork of child %d\n", pid1);
+  pid2 = fork1("XXp2", Spin, "XXp2", USLOSS_MIN_STACK, 2);
+  printf("start1(): after fork of child %d\n", pid2);
+  printf("start1(): set_tickets(%d, 300) returned %d\n", pid1,
+         set_tickets(pid1, 300));
+  printf("start1(): set_tickets(%d, 100) returned %d\n", pid2,
+         set_tickets(pid2, 100));
+  printf("start1(): set_tickets(%d, 0) returned %d\n", pid2,
+         set_tickets(pid2, 0));
+  printf("start1(): set_tickets(50, 100) returned %d\n",
+         set_tickets(50, 100));
+
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  kidpid = join(&status);
+  printf("start1(): exit status for child %d is %d\n", kidpid, status);
+  return 0;
+} /* start1 */
+
+int Spin(char *arg)
+{
+  printf("%s(): started\n", arg);
+  while (readtime() < 300)
+    ;
+  printf("%s(): done\n", arg);
+  quit(-getpid());
+  return 0;
+} /* Spin */
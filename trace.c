@@ -0,0 +1,115 @@
+/* ------------------------------------------------------------------------
+   trace.c
+
+   The trace ring and the trace_log() sink.  Only the kernel writes to
+   either, always with interrupts disabled, so there is a single producer
+   and no lock: a ring record is filled in first and then published by
+   advancing TraceCount.  Nothing on the ring's recording path allocates
+   or does I/O.
+
+   ------------------------------------------------------------------------ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <phase1.h>
+#include "trace.h"
+
+#if TRACE_RING
+
+static trace_record TraceRing[TRACE_RING_SIZE];
+
+/* number of records ever written */
+static volatile unsigned int TraceCount;
+
+
+void trace_event(int event, int pid1, int prio1, int pid2, int prio2)
+{
+   trace_record *rec = &TraceRing[TraceCount & (TRACE_RING_SIZE - 1)];
+
+   rec->time = sys_clock();
+   rec->event = event;
+   rec->prio1 = prio1;
+   rec->prio2 = prio2;
+   rec->pid1 = pid1;
+   rec->pid2 = pid2;
+   TraceCount++;
+} /* trace_event */
+
+
+/* ------------------------------------------------------------------------
+   Name - trace_save
+   Purpose - Writes the header and the raw ring to TRACE_FILE for
+             tracedump to decode.
+   Parameters - none
+   Returns - nothing
+   Side Effects - creates or overwrites TRACE_FILE
+   ----------------------------------------------------------------------- */
+void trace_save(void)
+{
+   FILE *out;
+   trace_header header;
+
+   out = fopen(TRACE_FILE, "wb");
+   if (out == NULL) {
+      console("trace_save(): cannot open %s\n", TRACE_FILE);
+      return;
+   }
+   header.magic = TRACE_MAGIC;
+   header.record_size = sizeof(trace_record);
+   header.ring_size = TRACE_RING_SIZE;
+   header.count = TraceCount;
+   fwrite(&header, sizeof(header), 1, out);
+   fwrite(TraceRing, sizeof(trace_record), TRACE_RING_SIZE, out);
+   fclose(out);
+} /* trace_save */
+
+#endif /* TRACE_RING */
+
+
+#if TRACE_LEVEL > 0
+
+static char TraceLog[TRACE_LOG_SIZE];
+
+/* bytes of TraceLog in use */
+static int TraceLogUsed;
+
+
+/* ------------------------------------------------------------------------
+   Name - trace_printf
+   Purpose - Formats a trace_log() message into the buffer, flushing the
+             buffer first if the message would not fit.
+   Parameters - printf-style format and arguments
+   Returns - nothing
+   Side Effects - may write to the console
+   ----------------------------------------------------------------------- */
+void trace_printf(char *fmt, ...)
+{
+   va_list ap;
+   int len;
+
+   va_start(ap, fmt);
+   len = vsnprintf(TraceLog + TraceLogUsed, TRACE_LOG_SIZE - TraceLogUsed,
+                   fmt, ap);
+   va_end(ap);
+   if (TraceLogUsed + len < TRACE_LOG_SIZE) {
+      TraceLogUsed += len;
+      return;
+   }
+
+   /* did not fit: flush what came before and format it again */
+   TraceLog[TraceLogUsed] = '\0';
+   trace_flush();
+   va_start(ap, fmt);
+   len = vsnprintf(TraceLog, TRACE_LOG_SIZE, fmt, ap);
+   va_end(ap);
+   TraceLogUsed = len < TRACE_LOG_SIZE ? len : TRACE_LOG_SIZE - 1;
+} /* trace_printf */
+
+
+void trace_flush(void)
+{
+   if (TraceLogUsed > 0)
+      console("%s", TraceLog);
+   TraceLogUsed = 0;
+} /* trace_flush */
+
+#endif /* TRACE_LEVEL > 0 */
@@ -0,0 +1,96 @@
+/* ------------------------------------------------------------------------
+   trace.h
+
+   Kernel tracing, all of it chosen at compile time from the Makefile.
+
+   TRACE_RING=1: a binary ring fed by the p1_fork/p1_switch/p1_quit
+   hooks.  Each event is a fixed-size record written into a
+   preallocated ring; the ring is saved to TRACE_FILE when the system
+   halts and decoded afterwards by tracedump.
+
+   TRACE_LEVEL, TRACE_CATS: text messages from phase1.c through
+   trace_log().  A message is compiled in only if its category is in
+   TRACE_CATS and its level is at most TRACE_LEVEL; the rest compile to
+   nothing.  Messages collect in a buffer that is written to the console
+   when it fills and when the system halts.
+
+   ------------------------------------------------------------------------ */
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#ifndef TRACE_RING
+#define TRACE_RING 0
+#endif
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 0
+#endif
+
+#ifndef TRACE_CATS
+#define TRACE_CATS TRACE_CAT_ALL
+#endif
+
+/* trace_log() levels */
+#define TRACE_INFO    1    /* process lifecycle and errors */
+#define TRACE_VERBOSE 2    /* every dispatch and wake-up */
+
+/* trace_log() categories, or'ed together in TRACE_CATS */
+#define TRACE_CAT_BOOT     0x01    /* startup, finish, sentinel */
+#define TRACE_CAT_SCHED    0x02    /* dispatcher, time slices */
+#define TRACE_CAT_FORK     0x04    /* fork1, launch */
+#define TRACE_CAT_JOIN     0x08    /* join, quit */
+#define TRACE_CAT_ZAP      0x10    /* zap, block_me, unblock_proc */
+#define TRACE_CAT_DEADLOCK 0x20    /* check_deadlock, wait-for graph */
+#define TRACE_CAT_ALL      0x3f
+
+#define TRACE_LOG_SIZE  8192          /* bytes buffered before a flush */
+
+#define TRACE_RING_SIZE 4096          /* records kept; a power of two */
+#define TRACE_FILE      "p1trace.bin"
+#define TRACE_MAGIC     0x52543150    /* "P1TR" */
+
+/* event codes */
+#define TRACE_FORK   1     /* pid1 = child, pid2 = parent */
+#define TRACE_SWITCH 2     /* pid1 = old, pid2 = new */
+#define TRACE_QUIT   3     /* pid1 = quitting process */
+
+typedef struct trace_record {
+   int            time;      /* sys_clock() in microseconds */
+   short          event;
+   signed char    prio1;     /* priority of pid1, -1 if unknown */
+   signed char    prio2;     /* priority of pid2, -1 if unknown */
+   int            pid1;
+   int            pid2;
+} trace_record;
+
+/* precedes the ring in TRACE_FILE */
+typedef struct trace_header {
+   unsigned int   magic;
+   unsigned int   record_size;
+   unsigned int   ring_size;
+   unsigned int   count;     /* records ever written; the ring holds the
+                                last ring_size of them */
+} trace_header;
+
+#if TRACE_RING
+extern void trace_event(int event, int pid1, int prio1, int pid2, int prio2);
+extern void trace_save(void);
+#else
+#define trace_event(event, pid1, prio1, pid2, prio2)
+#define trace_save()
+#endif
+
+#if TRACE_LEVEL > 0
+extern void trace_printf(char *fmt, ...);
+extern void trace_flush(void);
+#define trace_log(cat, level, ...)                                   \
+   do {                                                               \
+      if (((cat) & TRACE_CATS) && (level) <= TRACE_LEVEL)             \
+         trace_printf(__VA_ARGS__);                                   \
+   } while (0)
+#else
+#define trace_log(cat, level, ...)
+#define trace_flush()
+#endif
+
+#endif /* _TRACE_H */
@@ -0,0 +1,65 @@
+/* ------------------------------------------------------------------------
+   tracedump.c
+
+   Decodes a trace ring saved by the kernel, oldest record first, one
+   whitespace-separated line per event:
+
+      time_us event pid1 prio1 pid2 prio2
+
+   Usage: tracedump [file]     (default TRACE_FILE)
+
+   ------------------------------------------------------------------------ */
+#include <stdio.h>
+#include "trace.h"
+
+static const char *event_name(int event)
+{
+   switch (event) {
+   case TRACE_FORK:   return "fork";
+   case TRACE_SWITCH: return "switch";
+   case TRACE_QUIT:   return "quit";
+   default:           return "?";
+   }
+} /* event_name */
+
+
+int main(int argc, char *argv[])
+{
+   const char *path = argc > 1 ? argv[1] : TRACE_FILE;
+   FILE *in;
+   trace_header header;
+   trace_record rec;
+   unsigned int first, i;
+
+   in = fopen(path, "rb");
+   if (in == NULL) {
+      perror(path);
+      return 1;
+   }
+   if (fread(&header, sizeof(header), 1, in) != 1 ||
+       header.magic != TRACE_MAGIC ||
+       header.record_size != sizeof(trace_record)) {
+      fprintf(stderr, "%s: not a trace file from this kernel build\n", path);
+      return 1;
+   }
+
+   /* once the ring has wrapped, the oldest record is at count % size */
+   first = header.count > header.ring_size ? header.count - header.ring_size
+                                           : 0;
+   printf("# time_us event pid1 prio1 pid2 prio2\n");
+   for (i = first; i < header.count; i++) {
+      if (fseek(in, sizeof(header) +
+                (long) (i % header.ring_size) * sizeof(rec), SEEK_SET) != 0 ||
+          fread(&rec, sizeof(rec), 1, in) != 1) {
+         fprintf(stderr, "%s: truncated\n", path);
+         return 1;
+      }
+      printf("%d %s %d %d %d %d\n", rec.time, event_name(rec.event),
+             rec.pid1, rec.prio1, rec.pid2, rec.prio2);
+   }
+   if (first > 0)
+      fprintf(stderr, "%s: %u older records were overwritten\n",
+              path, first);
+   fclose(in);
+   return 0;
+} /* main */